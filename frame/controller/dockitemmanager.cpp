@@ -8,6 +8,7 @@
 #include "pluginsitem.h"
 #include "traypluginitem.h"
 #include "utils.h"
+#include "startuptracer.h"
 
 #include <QDebug>
 #include <QGSettings>
@@ -24,21 +25,17 @@ DockItemManager::DockItemManager(QObject *parent)
     , m_appInter(new DBusDock("com.deepin.dde.daemon.Dock", "/com/deepin/dde/daemon/Dock", QDBusConnection::sessionBus(), this))
     , m_pluginsInter(new DockPluginsController(this))
 {
+    TraceSpan span("DockItemManager");
+
     //固定区域：启动器
     m_itemList.append(new LauncherItem);
 
-    // 应用区域
-    for (auto entry : m_appInter->entries()) {
-        AppItem *it = new AppItem(m_appSettings, m_activeSettings, m_dockedSettings, entry);
-        manageItem(it);
-
-        connect(it, &AppItem::requestActivateWindow, m_appInter, &DBusDock::ActivateWindow, Qt::QueuedConnection);
-        connect(it, &AppItem::requestPreviewWindow, m_appInter, &DBusDock::PreviewWindow);
-        connect(it, &AppItem::requestCancelPreview, m_appInter, &DBusDock::CancelPreviewWindow);
-
-        connect(this, &DockItemManager::requestUpdateDockItem, it, &AppItem::requestUpdateEntryGeometries);
-
-        m_itemList.append(it);
+    // 应用区域，先并行获取所有应用的属性再创建
+    const QList<QDBusObjectPath> &entries = m_appInter->entries();
+    const QList<QVariantMap> &entryProperties = fetchEntryProperties(entries);
+    for (int i = 0; i < entries.size(); ++i) {
+        TraceSpan itemSpan("AppItem", entries.at(i).path());
+        m_itemList.append(createAppItem(entries.at(i), entryProperties.at(i)));
     }
 
     // 托盘区域和插件区域 由DockPluginsController获取
@@ -182,20 +179,16 @@ void DockItemManager::appItemAdded(const QDBusObjectPath &path, const int index)
                 ++insertIndex;
     }
 
-    AppItem *item = new AppItem(m_appSettings, m_activeSettings, m_dockedSettings, path);
+    const QVariantMap &properties = fetchEntryProperties(QList<QDBusObjectPath>() << path).first();
+    if (m_appIDist.contains(properties.value("Id").toString()))
+        return;
 
+    AppItem *item = createAppItem(path, properties);
     if (m_appIDist.contains(item->appId())) {
         delete item;
         return;
     }
 
-    manageItem(item);
-
-    connect(item, &AppItem::requestActivateWindow, m_appInter, &DBusDock::ActivateWindow, Qt::QueuedConnection);
-    connect(item, &AppItem::requestPreviewWindow, m_appInter, &DBusDock::PreviewWindow);
-    connect(item, &AppItem::requestCancelPreview, m_appInter, &DBusDock::CancelPreviewWindow);
-    connect(this, &DockItemManager::requestUpdateDockItem, item, &AppItem::requestUpdateEntryGeometries);
-
     m_itemList.insert(insertIndex, item);
     m_appIDist.append(item->appId());
 
@@ -318,6 +311,54 @@ void DockItemManager::reloadAppItems()
         appItemAdded(path, -1);
 }
 
+/**
+ * @brief DockItemManager::createAppItem 使用预先获取的属性创建应用图标
+ * @param path 应用的DBus路径
+ * @param properties 应用的属性，为空时由AppItem自己读取
+ */
+AppItem *DockItemManager::createAppItem(const QDBusObjectPath &path, const QVariantMap &properties)
+{
+    AppItem *item = new AppItem(m_appSettings, m_activeSettings, m_dockedSettings, path, properties);
+    manageItem(item);
+
+    connect(item, &AppItem::requestActivateWindow, m_appInter, &DBusDock::ActivateWindow, Qt::QueuedConnection);
+    connect(item, &AppItem::requestPreviewWindow, m_appInter, &DBusDock::PreviewWindow);
+    connect(item, &AppItem::requestCancelPreview, m_appInter, &DBusDock::CancelPreviewWindow);
+    connect(this, &DockItemManager::requestUpdateDockItem, item, &AppItem::requestUpdateEntryGeometries);
+
+    return item;
+}
+
+/**
+ * @brief DockItemManager::fetchEntryProperties 通过GetAll获取应用的所有属性
+ * @note 先发出所有请求再等待结果，N个应用只需要等待一次DBus往返，而不是每个应用的每个属性各同步读取一次
+ * @param entries 应用的DBus路径
+ * @return 和entries一一对应的属性，获取失败时为空
+ */
+QList<QVariantMap> DockItemManager::fetchEntryProperties(const QList<QDBusObjectPath> &entries)
+{
+    QList<QDBusPendingCall> calls;
+    for (const QDBusObjectPath &entry : entries) {
+        QDBusMessage msg = QDBusMessage::createMethodCall("com.deepin.dde.daemon.Dock", entry.path(), "org.freedesktop.DBus.Properties", "GetAll");
+        msg << DockEntryInter::staticInterfaceName();
+        calls << QDBusConnection::sessionBus().asyncCall(msg);
+    }
+
+    QList<QVariantMap> properties;
+    for (const QDBusPendingCall &call : calls) {
+        QDBusPendingReply<QVariantMap> reply = call;
+        reply.waitForFinished();
+        if (reply.isError()) {
+            qWarning() << "get entry properties failed:" << reply.error().message();
+            properties << QVariantMap();
+        } else {
+            properties << reply.value();
+        }
+    }
+
+    return properties;
+}
+
 void DockItemManager::manageItem(DockItem *item)
 {
     connect(item, &DockItem::requestRefreshWindowVisible, this, &DockItemManager::requestRefershWindowVisible, Qt::UniqueConnection);
@@ -327,4 +368,7 @@ void DockItemManager::manageItem(DockItem *item)
 void DockItemManager::onPluginLoadFinished()
 {
     updatePluginsItemOrderKey();
+
+    // 插件加载完成即启动完成
+    StartupTracer::instance()->dumpToEnvFile();
 }
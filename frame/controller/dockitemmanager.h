@@ -60,6 +60,8 @@ private:
     void updatePluginsItemOrderKey();
     void reloadAppItems();
     void manageItem(DockItem *item);
+    AppItem *createAppItem(const QDBusObjectPath &path, const QVariantMap &properties);
+    static QList<QVariantMap> fetchEntryProperties(const QList<QDBusObjectPath> &entries);
 
 private:
     DBusDock *m_appInter;
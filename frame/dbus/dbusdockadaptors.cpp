@@ -5,6 +5,7 @@
 #include "dbusdockadaptors.h"
 #include "utils.h"
 #include "dockitemmanager.h"
+#include "startuptracer.h"
 
 #include <QScreen>
 #include <QDebug>
@@ -162,6 +163,27 @@ void DBusDockAdaptors::setPluginVisible(const QString &pluginName, bool visible)
     qInfo() << "Unable to set information for this plugin";
 }
 
+/**
+ * @brief DBusDockAdaptors::StartTrace 开始记录各个阶段的耗时，例如在调用ReloadPlugins前开启
+ */
+void DBusDockAdaptors::StartTrace()
+{
+    StartupTracer::instance()->start();
+}
+
+/**
+ * @brief DBusDockAdaptors::StopTrace 停止记录并将记录以Chrome trace-event格式写入文件
+ * @param filePath 输出文件路径
+ * @return 是否写入成功
+ */
+bool DBusDockAdaptors::StopTrace(const QString &filePath)
+{
+    StartupTracer *tracer = StartupTracer::instance();
+    tracer->stop();
+
+    return tracer->dump(filePath);
+}
+
 QRect DBusDockAdaptors::geometry() const
 {
     return parent()->geometry();
@@ -42,6 +42,11 @@ class DBusDockAdaptors: public QDBusAbstractAdaptor
                                        "        <arg name=\"pluginName\" type=\"s\" direction=\"in\"/>"
                                        "        <arg name=\"visible\" type=\"b\" direction=\"in\"/>"
                                        "    </method>"
+                                       "    <method name=\"StartTrace\"/>"
+                                       "    <method name=\"StopTrace\">"
+                                       "        <arg name=\"filePath\" type=\"s\" direction=\"in\"/>"
+                                       "        <arg name=\"ok\" type=\"b\" direction=\"out\"/>"
+                                       "    </method>"
                                        "    <signal name=\"pluginVisibleChanged\">"
                                        "        <arg type=\"s\"/>"
                                        "        <arg type=\"b\"/>"
@@ -70,6 +75,9 @@ public Q_SLOTS: // METHODS
     bool getPluginVisible(const QString &pluginName);
     void setPluginVisible(const QString &pluginName, bool visible);
 
+    void StartTrace();
+    bool StopTrace(const QString &filePath);
+
 public: // PROPERTIES
     QRect geometry() const;
 
@@ -14,6 +14,7 @@ DisplayManager::DisplayManager(QObject *parent)
     : QObject(parent)
     , m_gsettings(Utils::SettingsPtr("com.deepin.dde.dock.mainwindow", "/com/deepin/dde/dock/mainwindow/", this))
     , m_onlyInPrimary(Utils::SettingValue("com.deepin.dde.dock.mainwindow", "/com/deepin/dde/dock/mainwindow/", "onlyShowPrimary", false).toBool())
+    , m_topology(new ScreenTopology)
 {
     connect(qApp, &QApplication::primaryScreenChanged, this, &DisplayManager::primaryScreenChanged);
     connect(qApp, &QApplication::primaryScreenChanged, this, &DisplayManager::dockInfoChanged);
@@ -67,12 +68,7 @@ QString DisplayManager::primary() const
  */
 int DisplayManager::screenRawWidth() const
 {
-    int width = 0;
-    for (auto s : m_screens) {
-        width = qMax(width, s->geometry().x() + int(s->geometry().width() * s->devicePixelRatio()));
-    }
-
-    return width;
+    return m_topology->rawWidth();
 }
 /**
  * @brief Display::screenHeight
@@ -81,12 +77,7 @@ int DisplayManager::screenRawWidth() const
 
 int DisplayManager::screenRawHeight() const
 {
-    int height = 0;
-    for (auto s : m_screens) {
-        height = qMax(height, s->geometry().y() + int(s->geometry().height() * s->devicePixelRatio()));
-    }
-
-    return height;
+    return m_topology->rawHeight();
 }
 
 /**
@@ -97,7 +88,7 @@ int DisplayManager::screenRawHeight() const
  */
 bool DisplayManager::canDock(QScreen *s, Position pos) const
 {
-    return s ? m_screenPositionMap[s].value(pos) : false;
+    return m_topology->canDock(m_topology->indexOf(s), pos);
 }
 
 /**判断屏幕是否为复制模式的依据，第一个屏幕的X和Y值是否和其他的屏幕的X和Y值相等
@@ -122,120 +113,26 @@ bool DisplayManager::isCopyMode()
     return true;
 }
 
+/**
+ * @brief DisplayManager::topology
+ * @return 当前的屏幕布局快照，快照本身不会被修改，布局变化后会替换为新的快照
+ */
+ScreenTopologyPtr DisplayManager::topology() const
+{
+    return m_topology;
+}
+
 /**
  * @brief DisplayManager::updateScreenDockInfo
- * 更新屏幕停靠信息
+ * 更新屏幕停靠信息，布局没有变化时保留原先的快照和版本号
  */
 void DisplayManager::updateScreenDockInfo()
 {
-    // 先清除原先的数据，然后再更新
-    m_screenPositionMap.clear();
-
-    if (m_screens.isEmpty())
+    ScreenTopologyPtr topology(new ScreenTopology(m_screens, qApp->primaryScreen(), m_onlyInPrimary, m_topology->version() + 1));
+    if (topology->sameLayout(*m_topology))
         return;
 
-    // reset map
-    for (auto s : m_screens) {
-        QMap <Position, bool> map;
-        map.insert(Position::Top, true);
-        map.insert(Position::Bottom, true);
-        map.insert(Position::Left, true);
-        map.insert(Position::Right, true);
-        m_screenPositionMap.insert(s, map);
-    }
-
-    // 仅显示在主屏时的处理
-    if (m_onlyInPrimary) {
-        for (auto s : m_screens) {
-            if (s != qApp->primaryScreen()) {
-                QMap <Position, bool> map;
-                map.insert(Position::Top, false);
-                map.insert(Position::Bottom, false);
-                map.insert(Position::Left, false);
-                map.insert(Position::Right, false);
-                m_screenPositionMap.insert(s, map);
-            }
-        }
-        return;
-    }
-
-    if (m_screens.size() == 1) {
-        return;
-    }
-
-    // 适配任意多个屏幕的情况
-    for(auto s : m_screens) {
-        QList<QScreen *> otherScreens = m_screens;
-        otherScreens.removeAll(s);
-        for (auto other : otherScreens) {
-            QRect ourRect = QRect(s->geometry().topLeft(), s->geometry().size() * s->devicePixelRatio());
-            int ourBottom = ourRect.top() + ourRect.height();
-            int ourTop = ourRect.top();
-            int ourLeft = ourRect.left();
-            int ourRight = ourRect.left() + ourRect.width();
-            QPoint ourLeftBottom = QPoint(ourLeft, ourBottom);
-            QPoint ourRightBottom = QPoint(ourRight, ourBottom);
-            QPoint ourRightTop = QPoint(ourRight, ourTop);
-
-            QRect otherRect = QRect(other->geometry().topLeft(), other->geometry().size() * other->devicePixelRatio());
-            int otherBottom = otherRect.top() + otherRect.height();
-            int otherTop = otherRect.top();
-            int otherLeft = otherRect.left();
-            int otherRight = otherRect.left() + otherRect.width();
-            QPoint otherLeftBottom = QPoint(otherLeft, otherBottom);
-            QPoint otherLeftTop = QPoint(otherLeft, otherTop);
-            QPoint otherRightTop = QPoint(otherRight, otherTop);
-
-            /*
-                     * 上下拼接，our屏幕左右移动。
-                     * our屏幕从other屏幕对角的左上侧向右移动，至other屏幕对角的右上侧位置
-              ---------                                   ---------
-              |       |                                   |       |
-              |  our  |           ======>>>>>             |  our  |
-              |       |                                   |       |
-              ---------------                       ---------------
-                    |       |                       |       |
-                    | other |                       | other |
-                    |       |                       |       |
-                    ---------                       ---------
-            */
-            // 上下拼接
-            if (ourBottom == otherTop
-                    && (ourRight >= otherLeft)
-                    && (ourLeft <= otherRight)) {
-                // 排除对角排列
-                if (ourLeftBottom == otherRightTop
-                        || ourRightBottom == otherLeftTop)
-                    continue;
-                m_screenPositionMap[s][Position::Bottom] = false;
-                m_screenPositionMap[other][Position::Top] = false;
-            }
-
-            /*
-                     * 左右拼接，our屏幕上下移动。
-                     * our屏幕从other屏幕对角的左上侧向下移动，至other屏幕对角的最左下侧位置
-              ---------                                          ---------
-              |       |                                          |       |
-              |  our  |              ======>>>>>        ---------| other |
-              |       |--------                         |        |       |
-              --------|       |                         |  our   |--------
-                      | other |                         |        |
-                      |       |                         ----------
-                      ---------
-            */
-            // 左右拼接
-            if (otherLeft == ourRight
-                    && (ourTop <= otherBottom)
-                    && (ourBottom >= otherTop)) {
-                // 排除对角排列
-                if (ourRightTop == otherLeftBottom
-                        || ourRightBottom == otherLeftTop)
-                    continue;
-                m_screenPositionMap[s][Position::Right] = false;
-                m_screenPositionMap[other][Position::Left] = false;
-            }
-        }
-    }
+    m_topology = topology;
 }
 
 /**
@@ -299,7 +196,8 @@ void DisplayManager::dockInfoChanged()
     updateScreenDockInfo();
 
 #ifdef QT_DEBUG
-    qInfo() << m_screenPositionMap;
+    for (int i = 0; i < m_topology->count(); ++i)
+        qInfo() << m_topology->screen(i)->name() << m_topology->rect(i) << m_topology->dockableEdges(i);
 #endif
 
     Q_EMIT screenInfoChanged();
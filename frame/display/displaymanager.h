@@ -9,6 +9,7 @@
 
 #include "singleton.h"
 #include "constants.h"
+#include "screentopology.h"
 
 using namespace Dock;
 
@@ -38,6 +39,7 @@ public:
     int screenRawHeight() const;
     bool canDock(QScreen *s, Position pos) const;
     bool isCopyMode();
+    ScreenTopologyPtr topology() const;
 
 private:
     void updateScreenDockInfo();
@@ -55,7 +57,7 @@ Q_SIGNALS:
 
 private:
     QList<QScreen *> m_screens;
-    QMap<QScreen *, QMap<Position, bool>> m_screenPositionMap;
+    ScreenTopologyPtr m_topology;               // 屏幕布局快照，只在布局变化时重新生成
     const QGSettings *m_gsettings;              // 多屏配置控制
     bool m_onlyInPrimary;
 };
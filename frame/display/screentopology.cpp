@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "screentopology.h"
+
+#include <QScreen>
+#include <QMultiHash>
+
+ScreenTopology::ScreenTopology()
+    : m_rawWidth(0)
+    , m_rawHeight(0)
+    , m_version(0)
+{
+}
+
+ScreenTopology::ScreenTopology(const QList<QScreen *> &screens, QScreen *primary, bool onlyInPrimary, quint64 version)
+    : m_rawWidth(0)
+    , m_rawHeight(0)
+    , m_version(version)
+{
+    m_screens.reserve(screens.size());
+    m_rects.reserve(screens.size());
+    for (QScreen *s : screens) {
+        m_screens.append(s);
+        m_rects.append(QRect(s->geometry().topLeft(), s->geometry().size() * s->devicePixelRatio()));
+    }
+
+    init(m_screens.indexOf(primary), onlyInPrimary);
+}
+
+/**
+ * @brief ScreenTopology::ScreenTopology 直接根据缩放后的屏幕区域生成，此时没有对应的QScreen
+ */
+ScreenTopology::ScreenTopology(const QVector<QRect> &rects, int primaryIndex, bool onlyInPrimary, quint64 version)
+    : m_screens(rects.size(), nullptr)
+    , m_rects(rects)
+    , m_rawWidth(0)
+    , m_rawHeight(0)
+    , m_version(version)
+{
+    init(primaryIndex, onlyInPrimary);
+}
+
+int ScreenTopology::indexOf(const QScreen *s) const
+{
+    return s ? m_screens.indexOf(const_cast<QScreen *>(s)) : -1;
+}
+
+/**
+ * @brief ScreenTopology::indexAt
+ * @param pos 未计算缩放的坐标
+ * @return 坐标所在屏幕的索引，不在任何屏幕上时返回-1
+ */
+int ScreenTopology::indexAt(const QPoint &pos) const
+{
+    // 屏幕数量最多十几个，顺序查找连续存放的区域即可
+    for (int i = 0; i < m_rects.size(); ++i) {
+        if (m_rects.at(i).contains(pos))
+            return i;
+    }
+
+    return -1;
+}
+
+QScreen *ScreenTopology::screenAt(const QPoint &pos) const
+{
+    return m_screens.value(indexAt(pos));
+}
+
+quint8 ScreenTopology::dockableEdges(int index) const
+{
+    return m_dockableEdges.value(index, 0);
+}
+
+/**
+ * @brief ScreenTopology::canDock
+ * @return 第index个屏幕的pos位置是否允许停靠任务栏
+ */
+bool ScreenTopology::canDock(int index, Position pos) const
+{
+    return dockableEdges(index) & (1 << pos);
+}
+
+/**
+ * @brief ScreenTopology::sameLayout
+ * @return 两份快照的屏幕、区域和可停靠位置是否完全一致，一致时不需要更新版本
+ */
+bool ScreenTopology::sameLayout(const ScreenTopology &other) const
+{
+    return m_screens == other.m_screens
+            && m_rects == other.m_rects
+            && m_dockableEdges == other.m_dockableEdges;
+}
+
+/**
+ * @brief ScreenTopology::init
+ * 计算所有屏幕的总大小和每个屏幕可停靠的位置，两个屏幕拼接处的位置不允许停靠
+ */
+void ScreenTopology::init(int primaryIndex, bool onlyInPrimary)
+{
+    const int size = m_rects.size();
+    m_dockableEdges.fill(AllEdges, size);
+
+    for (const QRect &rect : m_rects) {
+        m_rawWidth = qMax(m_rawWidth, rect.x() + rect.width());
+        m_rawHeight = qMax(m_rawHeight, rect.y() + rect.height());
+    }
+
+    // 仅显示在主屏时，其他屏幕都不允许停靠
+    if (onlyInPrimary) {
+        for (int i = 0; i < size; ++i) {
+            if (i != primaryIndex)
+                m_dockableEdges[i] = 0;
+        }
+        return;
+    }
+
+    if (size < 2)
+        return;
+
+    // 按上边缘和左边缘建立索引，每个屏幕只和边缘重合的屏幕比较，不需要两两比较所有屏幕
+    QMultiHash<int, int> topIndex;
+    QMultiHash<int, int> leftIndex;
+    for (int i = 0; i < size; ++i) {
+        topIndex.insert(m_rects.at(i).top(), i);
+        leftIndex.insert(m_rects.at(i).left(), i);
+    }
+
+    for (int i = 0; i < size; ++i) {
+        const QRect &ourRect = m_rects.at(i);
+        const int ourTop = ourRect.top();
+        const int ourBottom = ourRect.top() + ourRect.height();
+        const int ourLeft = ourRect.left();
+        const int ourRight = ourRect.left() + ourRect.width();
+
+        // 上下拼接，other屏幕的上边缘和our屏幕的下边缘重合
+        for (auto it = topIndex.constFind(ourBottom); it != topIndex.constEnd() && it.key() == ourBottom; ++it) {
+            const int j = it.value();
+            if (j == i)
+                continue;
+
+            const QRect &otherRect = m_rects.at(j);
+            const int otherLeft = otherRect.left();
+            const int otherRight = otherRect.left() + otherRect.width();
+            if (ourRight < otherLeft || ourLeft > otherRight)
+                continue;
+
+            // 排除对角排列
+            if (ourLeft == otherRight || ourRight == otherLeft)
+                continue;
+
+            m_dockableEdges[i] &= ~BottomEdge;
+            m_dockableEdges[j] &= ~TopEdge;
+        }
+
+        // 左右拼接，other屏幕的左边缘和our屏幕的右边缘重合
+        for (auto it = leftIndex.constFind(ourRight); it != leftIndex.constEnd() && it.key() == ourRight; ++it) {
+            const int j = it.value();
+            if (j == i)
+                continue;
+
+            const QRect &otherRect = m_rects.at(j);
+            const int otherTop = otherRect.top();
+            const int otherBottom = otherRect.top() + otherRect.height();
+            if (ourTop > otherBottom || ourBottom < otherTop)
+                continue;
+
+            // 排除对角排列
+            if (ourTop == otherBottom || ourBottom == otherTop)
+                continue;
+
+            m_dockableEdges[i] &= ~RightEdge;
+            m_dockableEdges[j] &= ~LeftEdge;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef SCREENTOPOLOGY_H
+#define SCREENTOPOLOGY_H
+
+#include "constants.h"
+
+#include <QRect>
+#include <QVector>
+#include <QSharedPointer>
+
+using namespace Dock;
+
+class QScreen;
+
+/**
+ * @brief The ScreenTopology class
+ * @note 屏幕布局的只读快照，保存每个屏幕缩放后的区域(左上角为逻辑坐标，大小为原始分辨率)和可停靠的位置，
+ * @note 只在屏幕增删或区域变化时由DisplayManager重新生成，使用者通过共享指针引用同一份数据，不需要反复遍历QScreen计算
+ */
+class ScreenTopology
+{
+public:
+    // 可停靠位置的掩码，和Position一一对应
+    enum Edge {
+        TopEdge     = 1 << Top,
+        RightEdge   = 1 << Right,
+        BottomEdge  = 1 << Bottom,
+        LeftEdge    = 1 << Left,
+        AllEdges    = TopEdge | RightEdge | BottomEdge | LeftEdge
+    };
+
+    ScreenTopology();
+    ScreenTopology(const QList<QScreen *> &screens, QScreen *primary, bool onlyInPrimary, quint64 version);
+    ScreenTopology(const QVector<QRect> &rects, int primaryIndex, bool onlyInPrimary, quint64 version);
+
+    inline quint64 version() const { return m_version; }
+    inline int count() const { return m_rects.size(); }
+    inline QScreen *screen(int index) const { return m_screens.value(index); }
+    inline const QRect &rect(int index) const { return m_rects.at(index); }
+    inline int rawWidth() const { return m_rawWidth; }
+    inline int rawHeight() const { return m_rawHeight; }
+
+    int indexOf(const QScreen *s) const;
+    int indexAt(const QPoint &pos) const;
+    QScreen *screenAt(const QPoint &pos) const;
+    quint8 dockableEdges(int index) const;
+    bool canDock(int index, Position pos) const;
+    bool sameLayout(const ScreenTopology &other) const;
+
+private:
+    void init(int primaryIndex, bool onlyInPrimary);
+
+private:
+    QVector<QScreen *> m_screens;
+    QVector<QRect> m_rects;
+    QVector<quint8> m_dockableEdges;
+    int m_rawWidth;
+    int m_rawHeight;
+    quint64 m_version;
+};
+
+typedef QSharedPointer<const ScreenTopology> ScreenTopologyPtr;
+
+#endif // SCREENTOPOLOGY_H
@@ -4,6 +4,7 @@
 
 #include "appitem.h"
 #include "themeappicon.h"
+#include "themeiconresolver.h"
 #include "xcb_misc.h"
 #include "appswingeffectbuilder.h"
 #include "utils.h"
@@ -31,7 +32,31 @@ DCORE_USE_NAMESPACE
 
 QPoint AppItem::MousePressPos;
 
-AppItem::AppItem(const QGSettings *appSettings, const QGSettings *activeAppSettings, const QGSettings *dockedAppSettings, const QDBusObjectPath &entry, QWidget *parent)
+/**
+ * @brief previewTitleDisplayMode 预览标题显示方式的配置
+ * 所有应用共用一个DConfig并缓存配置值，配置变化时更新，不需要每次显示预览时创建
+ * @return 没有此配置时返回-1
+ */
+static int previewTitleDisplayMode()
+{
+    static int mode = -1;
+    static DConfig *config = nullptr;
+    if (!config) {
+        config = DConfig::create("org.deepin.dde.dock", "org.deepin.dde.dock", QString(), qApp);
+        auto update = [ ] {
+            mode = (config->isValid() && config->keyList().contains("showWindowName")) ? config->value("showWindowName").toInt() : -1;
+        };
+        QObject::connect(config, &DConfig::valueChanged, config, [ update ](const QString &key) {
+            if (key == "showWindowName")
+                update();
+        });
+        update();
+    }
+
+    return mode;
+}
+
+AppItem::AppItem(const QGSettings *appSettings, const QGSettings *activeAppSettings, const QGSettings *dockedAppSettings, const QDBusObjectPath &entry, const QVariantMap &properties, QWidget *parent)
     : DockItem(parent)
     , m_appSettings(appSettings)
     , m_activeAppSettings(activeAppSettings)
@@ -50,18 +75,25 @@ AppItem::AppItem(const QGSettings *appSettings, const QGSettings *activeAppSetti
     , m_updateIconGeometryTimer(new QTimer(this))
     , m_retryObtainIconTimer(new QTimer(this))
     , m_refershIconTimer(new QTimer(this))
+    , m_iconResizePolicy(this, [ this ] { refreshIcon(); })
+    , m_iconSize(0)
+    , m_iconWatcher(new QFutureWatcher<QImage>(this))
     , m_themeType(DGuiApplicationHelper::instance()->themeType())
 {
     QHBoxLayout *centralLayout = new QHBoxLayout;
     centralLayout->setMargin(0);
     centralLayout->setSpacing(0);
 
-    setObjectName(m_itemEntryInter->name());
+    // 已经预先获取到属性时直接使用，不再逐个同步读取DBus属性
+    const bool prefetched = !properties.isEmpty();
+
+    setObjectName(prefetched ? properties.value("Name").toString() : m_itemEntryInter->name());
     setAcceptDrops(true);
     setLayout(centralLayout);
 
-    m_id = m_itemEntryInter->id();
-    m_active = m_itemEntryInter->isActive();
+    m_id = prefetched ? properties.value("Id").toString() : m_itemEntryInter->id();
+    m_active = prefetched ? properties.value("IsActive").toBool() : m_itemEntryInter->isActive();
+    m_icon = prefetched ? properties.value("Icon").toString() : m_itemEntryInter->icon();
 
     m_updateIconGeometryTimer->setInterval(500);
     m_updateIconGeometryTimer->setSingleShot(true);
@@ -75,14 +107,18 @@ AppItem::AppItem(const QGSettings *appSettings, const QGSettings *activeAppSetti
     connect(m_itemEntryInter, &DockEntryInter::IsActiveChanged, this, &AppItem::activeChanged);
     connect(m_itemEntryInter, &DockEntryInter::IsActiveChanged, this, static_cast<void (AppItem::*)()>(&AppItem::update));
     connect(m_itemEntryInter, &DockEntryInter::WindowInfosChanged, this, &AppItem::updateWindowInfos, Qt::QueuedConnection);
-    connect(m_itemEntryInter, &DockEntryInter::IconChanged, this, &AppItem::refreshIcon);
+    connect(m_itemEntryInter, &DockEntryInter::IconChanged, this, [ this ](const QString &icon) {
+        m_icon = icon;
+        refreshIcon();
+    });
 
     connect(m_updateIconGeometryTimer, &QTimer::timeout, this, &AppItem::updateWindowIconGeometries, Qt::QueuedConnection);
     connect(m_retryObtainIconTimer, &QTimer::timeout, this, &AppItem::refreshIcon, Qt::QueuedConnection);
+    connect(m_iconWatcher, &QFutureWatcher<QImage>::finished, this, &AppItem::onIconResolved);
 
     connect(this, &AppItem::requestUpdateEntryGeometries, this, &AppItem::updateWindowIconGeometries);
 
-    updateWindowInfos(m_itemEntryInter->windowInfos());
+    updateWindowInfos(prefetched ? qdbus_cast<WindowInfoMap>(properties.value("WindowInfos")) : m_itemEntryInter->windowInfos());
     refreshIcon();
 
     if (m_appSettings)
@@ -178,6 +214,33 @@ void AppItem::moveEvent(QMoveEvent *e)
     m_updateIconGeometryTimer->start();
 }
 
+/**
+ * @brief indicatorPixmap 获取应用下方的指示器图片
+ * @note 所有应用共用，按照(主题, 方向, 是否激活, 缩放比例)缓存，只在第一次使用时解析svg
+ */
+static const QPixmap &indicatorPixmap(DGuiApplicationHelper::ColorType themeType, bool vertical, bool active, qreal ratio)
+{
+    static QHash<quint64, QPixmap> cache;
+
+    const quint64 key = (quint64(qRound(ratio * 100)) << 8)
+            | (quint64(themeType) << 2) | (quint64(vertical) << 1) | quint64(active);
+
+    auto it = cache.constFind(key);
+    if (it != cache.constEnd())
+        return it.value();
+
+    QString path;
+    if (active)
+        path = vertical ? ":/indicator/resources/indicator_active_ver.svg" : ":/indicator/resources/indicator_active.svg";
+    else if (DGuiApplicationHelper::DarkType == themeType)
+        path = vertical ? ":/indicator/resources/indicator_dark_ver.svg" : ":/indicator/resources/indicator_dark.svg";
+    else
+        path = vertical ? ":/indicator/resources/indicator_ver.svg" : ":/indicator/resources/indicator.svg";
+
+    // 保持svg原本的大小，按照缩放比例渲染
+    return cache.insert(key, Utils::renderSVG(path, QImageReader(path).size(), ratio)).value();
+}
+
 void AppItem::paintEvent(QPaintEvent *e)
 {
     DockItem::paintEvent(e);
@@ -215,49 +278,31 @@ void AppItem::paintEvent(QPaintEvent *e)
         }
     } else {
         if (!m_windowInfos.isEmpty()) {
-            QPoint p;
-            QPixmap pixmap;
-            QPixmap activePixmap;
-            if (DGuiApplicationHelper::DarkType == m_themeType) {
-                m_horizontalIndicator = QPixmap(":/indicator/resources/indicator_dark.svg");
-                m_verticalIndicator = QPixmap(":/indicator/resources/indicator_dark_ver.svg");
-            } else {
-                m_horizontalIndicator = QPixmap(":/indicator/resources/indicator.svg");
-                m_verticalIndicator = QPixmap(":/indicator/resources/indicator_ver.svg");
-            }
-            m_activeHorizontalIndicator = QPixmap(":/indicator/resources/indicator_active.svg");
-            m_activeVerticalIndicator = QPixmap(":/indicator/resources/indicator_active_ver.svg");
+            const bool vertical = (DockPosition == Left || DockPosition == Right);
+            const QPixmap &pixmap = indicatorPixmap(m_themeType, vertical, m_active, devicePixelRatioF());
+            const QSizeF size = QSizeF(pixmap.size()) / pixmap.devicePixelRatioF();
+
+            QPointF p;
             switch (DockPosition) {
             case Top:
-                pixmap = m_horizontalIndicator;
-                activePixmap = m_activeHorizontalIndicator;
-                p.setX((itemRect.width() - pixmap.width()) / 2);
+                p.setX((itemRect.width() - size.width()) / 2);
                 p.setY(1);
                 break;
             case Bottom:
-                pixmap = m_horizontalIndicator;
-                activePixmap = m_activeHorizontalIndicator;
-                p.setX((itemRect.width() - pixmap.width()) / 2);
-                p.setY(itemRect.height() - pixmap.height() - 1);
+                p.setX((itemRect.width() - size.width()) / 2);
+                p.setY(itemRect.height() - size.height() - 1);
                 break;
             case Left:
-                pixmap = m_verticalIndicator;
-                activePixmap = m_activeVerticalIndicator;
                 p.setX(1);
-                p.setY((itemRect.height() - pixmap.height()) / 2);
+                p.setY((itemRect.height() - size.height()) / 2);
                 break;
             case Right:
-                pixmap = m_verticalIndicator;
-                activePixmap = m_activeVerticalIndicator;
-                p.setX(itemRect.width() - pixmap.width() - 1);
-                p.setY((itemRect.height() - pixmap.height()) / 2);
+                p.setX(itemRect.width() - size.width() - 1);
+                p.setY((itemRect.height() - size.height()) / 2);
                 break;
             }
 
-            if (m_active)
-                painter.drawPixmap(p, activePixmap);
-            else
-                painter.drawPixmap(p, pixmap);
+            painter.drawPixmap(p, pixmap);
         }
     }
 
@@ -268,7 +313,10 @@ void AppItem::paintEvent(QPaintEvent *e)
     if (m_appIcon.isNull())
         return;
 
-    painter.drawPixmap(appIconPosition(), m_appIcon);
+    if (qMin(width(), height()) != m_iconSize)
+        painter.drawPixmap(scaledAppIconRect(), m_appIcon, m_appIcon.rect());
+    else
+        painter.drawPixmap(appIconPosition(), m_appIcon);
 }
 
 void AppItem::mouseReleaseEvent(QMouseEvent *e)
@@ -366,7 +414,18 @@ void AppItem::resizeEvent(QResizeEvent *e)
 {
     DockItem::resizeEvent(e);
 
-    refreshIcon();
+    // 图标区域大小没有变化时不需要重新获取图标
+    if (qMin(width(), height()) == m_iconSize)
+        return;
+
+    if (m_appIcon.isNull()) {
+        refreshIcon();
+        return;
+    }
+
+    // 拖拽调整任务栏大小时先缩放绘制当前的图标，拖拽结束后再按照新的大小获取
+    update();
+    m_iconResizePolicy.requestRefresh();
 }
 
 void AppItem::dragEnterEvent(QDragEnterEvent *e)
@@ -544,6 +603,19 @@ QPoint AppItem::appIconPosition() const
     return QPoint(iconX, iconY);
 }
 
+/**
+ * @brief AppItem::scaledAppIconRect
+ * @return 图标还没有按照新的大小重新获取时，将当前图标按比例缩放后绘制的区域
+ */
+QRectF AppItem::scaledAppIconRect() const
+{
+    const qreal scale = m_iconSize > 0 ? qreal(qMin(width(), height())) / m_iconSize : 1.0;
+    QRectF iconRect(QPointF(0, 0), QSizeF(m_appIcon.size()) / devicePixelRatioF() * scale);
+    iconRect.moveCenter(QRectF(rect()).center());
+
+    return iconRect;
+}
+
 void AppItem::updateWindowInfos(const WindowInfoMap &info)
 {
     m_windowInfos = info;
@@ -567,15 +639,21 @@ void AppItem::refreshIcon()
     if (!isVisible())
         return;
 
-    const QString icon = m_itemEntryInter->icon();
+    QString icon = m_icon;
     const int iconSize = qMin(width(), height());
+    m_iconSize = iconSize;
+    m_iconResizePolicy.cancel();
+
+    // 后台线程已经查找到图标文件时，直接使用该文件
+    if (!m_resolvedIconPath.isEmpty() && m_resolvingIcon == icon)
+        icon = m_resolvedIconPath;
 
     if (DockDisplayMode == Efficient)
-        m_iconValid = ThemeAppIcon::getIcon(m_appIcon, icon, iconSize * 0.7, !m_iconValid);
+        m_iconValid = ThemeAppIcon::getIcon(m_appIcon, icon, iconSize * 0.7);
     else
-        m_iconValid = ThemeAppIcon::getIcon(m_appIcon, icon, iconSize * 0.8, !m_iconValid);
+        m_iconValid = ThemeAppIcon::getIcon(m_appIcon, icon, iconSize * 0.8);
 
-    if (!m_refershIconTimer->isActive() && m_itemEntryInter->icon() == "dde-calendar") {
+    if (!m_refershIconTimer->isActive() && m_icon == "dde-calendar") {
         m_refershIconTimer->start();
     }
 
@@ -587,6 +665,13 @@ void AppItem::refreshIcon()
             // QIcon::setThemeSearchPaths will force Qt to re-check the gtk cache validity.
             QIcon::setThemeSearchPaths(QIcon::themeSearchPaths());
 
+            // 先显示默认图标，在后台线程中按照图标主题重新查找，找到后再刷新
+            if (!m_iconWatcher->isRunning() && icon == m_icon) {
+                m_resolvingIcon = icon;
+                m_resolvedIconPath.clear();
+                m_iconWatcher->setFuture(ThemeIconResolver::instance()->resolveImage(icon, m_appIcon.width()));
+            }
+
             m_retryObtainIconTimer->start();
         } else {
             // 如果图标获取失败，一分钟后再自动刷新一次（如果还是显示异常，基本需要应用自身看下为什么了）
@@ -616,6 +701,27 @@ void AppItem::onRefreshIcon()
     refreshIcon();
 }
 
+void AppItem::onIconResolved()
+{
+    const QImage &image = m_iconWatcher->result();
+    if (image.isNull() || m_resolvingIcon != m_icon)
+        return;
+
+    // 查找期间图标大小可能发生了变化，以当前的默认图标大小为准
+    const int size = m_appIcon.isNull() ? image.width() : m_appIcon.width();
+    m_resolvedIconPath = ThemeIconResolver::instance()->lookup(m_resolvingIcon, qMax(image.width(), image.height()));
+    m_appIcon = QPixmap::fromImage(image.width() == size ? image : image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    m_appIcon.setDevicePixelRatio(qApp->devicePixelRatio());
+
+    m_iconValid = true;
+    m_retryTimes = 0;
+    m_retryObtainIconTimer->stop();
+
+    update();
+
+    m_updateIconGeometryTimer->start();
+}
+
 void AppItem::onResetPreview()
 {
     if (m_appPreviewTips != nullptr) {
@@ -649,10 +755,9 @@ void AppItem::showPreview()
     connect(m_appPreviewTips, &PreviewContainer::requestHidePopup, this, &AppItem::onResetPreview);
 
     // 预览标题显示方式的配置
-    DConfig *config = DConfig::create("org.deepin.dde.dock", "org.deepin.dde.dock");
-    if (config->isValid() && config->keyList().contains("showWindowName"))
-        m_appPreviewTips->setTitleDisplayMode(config->value("showWindowName").toInt());
-    delete config;
+    const int titleDisplayMode = previewTitleDisplayMode();
+    if (titleDisplayMode != -1)
+        m_appPreviewTips->setTitleDisplayMode(titleDisplayMode);
 
     showPopupWindow(m_appPreviewTips, true);
 }
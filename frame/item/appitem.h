@@ -9,11 +9,13 @@
 #include "previewcontainer.h"
 #include "appdrag.h"
 #include "dbusclientmanager.h"
+#include "iconresizepolicy.h"
 #include "../widgets/tipswidget.h"
 
 #include <QGraphicsView>
 #include <QGraphicsItem>
 #include <QGraphicsItemAnimation>
+#include <QFutureWatcher>
 #include <DGuiApplicationHelper>
 
 #include <com_deepin_dde_daemon_dock_entry.h>
@@ -26,7 +28,7 @@ class AppItem : public DockItem
     Q_OBJECT
 
 public:
-    explicit AppItem(const QGSettings *appSettings, const QGSettings *activeAppSettings, const QGSettings *dockedAppSettings, const QDBusObjectPath &entry, QWidget *parent = nullptr);
+    explicit AppItem(const QGSettings *appSettings, const QGSettings *activeAppSettings, const QGSettings *dockedAppSettings, const QDBusObjectPath &entry, const QVariantMap &properties = QVariantMap(), QWidget *parent = nullptr);
     ~AppItem() override;
 
     void checkEntry() override;
@@ -71,6 +73,7 @@ private:
     bool hasAttention() const;
 
     QPoint appIconPosition() const;
+    QRectF scaledAppIconRect() const;
 
 private slots:
     void updateWindowInfos(const WindowInfoMap &info);
@@ -86,6 +89,7 @@ private slots:
 
     void onRefreshIcon();
     void onResetPreview();
+    void onIconResolved();
 
 private:
     const QGSettings *m_appSettings;
@@ -110,15 +114,17 @@ private:
 
     WindowInfoMap m_windowInfos;
     QString m_id;
+    QString m_icon;
     QPixmap m_appIcon;
-    QPixmap m_horizontalIndicator;
-    QPixmap m_verticalIndicator;
-    QPixmap m_activeHorizontalIndicator;
-    QPixmap m_activeVerticalIndicator;
 
     QTimer *m_updateIconGeometryTimer;
     QTimer *m_retryObtainIconTimer;
     QTimer *m_refershIconTimer;         // 当APP为日历时定时（1S）检测是否刷新ICON
+    IconResizePolicy m_iconResizePolicy;    // 拖拽调整任务栏大小结束后再重新获取图标
+    int m_iconSize;                     // 当前图标对应的图标区域大小
+    QFutureWatcher<QImage> *m_iconWatcher;  // 主题中直接获取图标失败时，在后台线程中重新查找
+    QString m_resolvingIcon;
+    QString m_resolvedIconPath;
 
     QDate m_curDate;                    // 保存当前icon的日期来判断是否需要更新日历APP的ICON
 
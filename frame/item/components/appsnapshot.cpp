@@ -6,6 +6,7 @@
 #include "previewcontainer.h"
 #include "../widgets/tipswidget.h"
 #include "utils.h"
+#include "snapshotcache.h"
 
 #include <DStyle>
 
@@ -20,6 +21,11 @@
 #include <QVBoxLayout>
 #include <QSizeF>
 #include <QTimer>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QtConcurrent>
 
 struct SHMInfo {
     long shmid;
@@ -38,11 +44,19 @@ struct SHMInfo {
 
 using namespace Dock;
 
+struct SnapshotResult {
+    QImage image;
+    QRectF srcRect;
+};
+
 AppSnapshot::AppSnapshot(const WId wid, QWidget *parent)
     : QWidget(parent)
     , m_wid(wid)
     , m_closeAble(false)
     , m_isWidowHidden(false)
+    , m_fetchSerial(new QAtomicInteger<quint64>(0))
+    , m_fetching(false)
+    , m_fetchCanceled(false)
     , m_title(new TipsWidget(this))
     , m_3DtitleBtn(nullptr)
     , m_waitLeaveTimer(new QTimer(this))
@@ -73,6 +87,12 @@ AppSnapshot::AppSnapshot(const WId wid, QWidget *parent)
     QTimer::singleShot(1, this, &AppSnapshot::compositeChanged);
 }
 
+AppSnapshot::~AppSnapshot()
+{
+    // 预览窗口关闭时取消还未完成的截图
+    cancelFetch();
+}
+
 void AppSnapshot::setWindowState()
 {
     if (m_isWidowHidden) {
@@ -183,103 +203,220 @@ void AppSnapshot::dragEnterEvent(QDragEnterEvent *e)
         emit entered(m_wid);
 }
 
+/**
+ * @brief AppSnapshot::fetchSnapshot 异步获取窗口截图
+ * @note D-Bus调用不阻塞界面，图片的解码和缩放在工作线程中进行，完成后再刷新界面，
+ * @note 新的请求会丢弃之前还未完成的请求
+ */
 void AppSnapshot::fetchSnapshot()
 {
     if (!m_wmHelper->hasComposite())
         return;
 
-    QImage qimage;
-    SHMInfo *info = nullptr;
-    uchar *image_data = nullptr;
-    XImage *ximage = nullptr;
-
-    do {
-        // 优先使用窗管进行窗口截图
-        if (isKWinAvailable()) {
-            QDBusInterface interface(QStringLiteral("org.kde.KWin"), QStringLiteral("/Screenshot"), QStringLiteral("org.kde.kwin.Screenshot"));
-            qDebug() << "windowsID:"<< m_wid;
-
-            QList<QVariant> args;
-            args << QVariant::fromValue(m_wid);
-            args << QVariant::fromValue(quint32(SNAP_WIDTH));
-            args << QVariant::fromValue(quint32(SNAP_HEIGHT));
-
-            QDBusReply<QString> reply = interface.callWithArgumentList(QDBus::Block,QStringLiteral("screenshotForWindowExtend"), args);
-            if(reply.isValid()){
-                const QString tmpFile = reply.value();
-                if (QFile::exists(tmpFile)) {
-                    m_snapshot.load(tmpFile);
-                    m_snapshotSrcRect = m_snapshot.rect();
-                    qDebug() << "reply: " << tmpFile;
-                    QFile::remove(tmpFile);
-                    break;
-                }  else {
-                    qDebug() << "get current workspace bckground error, file does not exist : " << tmpFile;
-                }
-            } else {
-                qDebug() << "get current workspace bckground error: "<< reply.error().message();
-            }
+    const quint64 serial = ++(*m_fetchSerial);
+    m_fetchCanceled = false;
+
+    // 窗口内容没有变化时直接使用缓存的截图
+    if (SnapshotCache::instance()->find(m_wid, snapshotSize(), m_snapshot, m_snapshotSrcRect)) {
+        m_fetching = false;
+        update();
+        return;
+    }
+
+    m_fetching = true;
+
+    // 优先使用窗管进行窗口截图，KWin未启动时调用直接返回错误
+    QDBusMessage msg = QDBusMessage::createMethodCall(QStringLiteral("org.kde.KWin"), QStringLiteral("/Effects"),
+                                                      QStringLiteral("org.kde.kwin.Effects"), QStringLiteral("isEffectLoaded"));
+    msg << QStringLiteral("screenshot");
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(msg), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [ = ] {
+        watcher->deleteLater();
+        if (serial != *m_fetchSerial)
+            return;
+
+        QDBusPendingReply<bool> reply = *watcher;
+        if (!reply.isError() && reply.value())
+            fetchSnapshotFromKWin(serial);
+        else
+            fetchSnapshotFromX11(serial);
+    });
+}
+
+void AppSnapshot::fetchSnapshotFromKWin(quint64 serial)
+{
+    qDebug() << "windowsID:"<< m_wid;
+
+    QDBusMessage msg = QDBusMessage::createMethodCall(QStringLiteral("org.kde.KWin"), QStringLiteral("/Screenshot"),
+                                                      QStringLiteral("org.kde.kwin.Screenshot"), QStringLiteral("screenshotForWindowExtend"));
+    QList<QVariant> args;
+    args << QVariant::fromValue(m_wid);
+    args << QVariant::fromValue(quint32(SNAP_WIDTH));
+    args << QVariant::fromValue(quint32(SNAP_HEIGHT));
+    msg.setArguments(args);
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(msg), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [ = ] {
+        watcher->deleteLater();
+
+        QDBusPendingReply<QString> reply = *watcher;
+        if (reply.isError()) {
+            qDebug() << "get current workspace bckground error: "<< reply.error().message();
+            if (serial == *m_fetchSerial)
+                fetchSnapshotFromX11(serial);
+            return;
         }
 
-        // get window image from shm(only for deepin app)
-        info = getImageDSHM();
-        if (info) {
-            qDebug() << "get Image from dxcbplugin SHM...";
-            image_data = (uchar *)shmat(info->shmid, 0, 0);
-            if ((qint64)image_data != -1) {
-                m_snapshot = QImage(image_data, info->width, info->height, info->bytesPerLine, (QImage::Format)info->format);
-                m_snapshotSrcRect = QRect(info->rect.x, info->rect.y, info->rect.width, info->rect.height);
-                break;
-            }
-            qDebug() << "invalid pointer of shm!";
-            image_data = nullptr;
+        const QString tmpFile = reply.value();
+        if (!QFile::exists(tmpFile)) {
+            qDebug() << "get current workspace bckground error, file does not exist : " << tmpFile;
+            if (serial == *m_fetchSerial)
+                fetchSnapshotFromX11(serial);
+            return;
         }
 
-        if (!Utils::IS_WAYLAND_DISPLAY && (!image_data || qimage.isNull())) {
-            // get window image from XGetImage(a little slow)
-            qDebug() << "get Image from dxcbplugin SHM failed!";
-            qDebug() << "get Image from Xlib...";
-            // guoyao note：这里会造成内存泄漏，而且是通过demo在X环境经过验证，改用xcb库同样会有内存泄漏，这里暂时未找到解决方案，所以优先使用kwin提供的接口
-            ximage = getImageXlib();
-            if (!ximage) {
-                qDebug() << "get Image from Xlib failed! giving up...";
-                emit requestCheckWindow();
-                return;
-            }
-            qimage = QImage((const uchar *)(ximage->data), ximage->width, ximage->height, ximage->bytes_per_line, QImage::Format_RGB32);
-
-            if (!qimage.isNull()) {
-                m_snapshot = qimage;
-                // remove shadow frame
-                m_snapshotSrcRect = rectRemovedShadow(qimage, nullptr);
-            } else {
-                qDebug() << "can not get QImage! giving up...";
-            }
+        qDebug() << "reply: " << tmpFile;
+        // 请求已被取消时也需要在工作线程中删除临时文件
+        scaleSnapshot(serial, QImage(), QRectF(), tmpFile, nullptr);
+    });
+}
+
+void AppSnapshot::fetchSnapshotFromX11(quint64 serial)
+{
+    // get window image from shm(only for deepin app)
+    SHMInfo *info = getImageDSHM();
+    if (info) {
+        qDebug() << "get Image from dxcbplugin SHM...";
+        uchar *image_data = (uchar *)shmat(info->shmid, 0, 0);
+        if ((qint64)image_data != -1) {
+            const QImage image(image_data, info->width, info->height, info->bytesPerLine, (QImage::Format)info->format);
+            const QRectF srcRect(info->rect.x, info->rect.y, info->rect.width, info->rect.height);
+            XFree(info);
+            scaleSnapshot(serial, image, srcRect, QString(), [ = ] { shmdt(image_data); });
+            return;
         }
-    } while(false);
+        qDebug() << "invalid pointer of shm!";
+        XFree(info);
+    }
 
-    // 如果m_snapshot或m_snapshotSrcRect为空，说明三种方式均失败，返回不做处理
-    if (m_snapshot.isNull() || m_snapshotSrcRect.isNull()) {
+    if (Utils::IS_WAYLAND_DISPLAY) {
+        m_fetching = false;
         qWarning() << "can not get QImage or QRectF! giving up...";
         return;
     }
 
-    QSizeF size(rect().marginsRemoved(QMargins(8, 8, 8, 8)).size());
-    const auto ratio = devicePixelRatioF();
-    size = m_snapshotSrcRect.size().scaled(size * ratio, Qt::KeepAspectRatio);
-    qreal scale = qreal(size.width()) / m_snapshotSrcRect.width();
-    m_snapshot = m_snapshot.scaled(qRound(m_snapshot.width() * scale), qRound(m_snapshot.height() * scale),
-                                   Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-    m_snapshotSrcRect.moveTop(m_snapshotSrcRect.top() * scale + 0.5);
-    m_snapshotSrcRect.moveLeft(m_snapshotSrcRect.left() * scale + 0.5);
-    m_snapshotSrcRect.setWidth(size.width() - 0.5);
-    m_snapshotSrcRect.setHeight(size.height() - 0.5);
-
-    if (image_data) shmdt(image_data);
-    if (ximage) XDestroyImage(ximage);
-    if (info) XFree(info);
+    // get window image from XGetImage(a little slow)
+    qDebug() << "get Image from dxcbplugin SHM failed!";
+    qDebug() << "get Image from Xlib...";
+    // guoyao note：这里会造成内存泄漏，而且是通过demo在X环境经过验证，改用xcb库同样会有内存泄漏，这里暂时未找到解决方案，所以优先使用kwin提供的接口
+    XImage *ximage = getImageXlib();
+    if (!ximage) {
+        m_fetching = false;
+        qDebug() << "get Image from Xlib failed! giving up...";
+        emit requestCheckWindow();
+        return;
+    }
 
-    update();
+    const QImage image((const uchar *)(ximage->data), ximage->width, ximage->height, ximage->bytes_per_line, QImage::Format_RGB32);
+    if (image.isNull()) {
+        m_fetching = false;
+        qDebug() << "can not get QImage! giving up...";
+        XDestroyImage(ximage);
+        return;
+    }
+
+    // remove shadow frame
+    scaleSnapshot(serial, image, rectRemovedShadow(image, nullptr), QString(), [ = ] { XDestroyImage(ximage); });
+}
+
+/**
+ * @brief AppSnapshot::scaleSnapshot 在工作线程中读取、缩放截图
+ * @param image 截图，image为空时从tmpFile读取
+ * @param tmpFile KWin截图生成的临时文件，读取后删除
+ * @param release 缩放完成后释放image引用的共享内存或XImage
+ */
+void AppSnapshot::scaleSnapshot(quint64 serial, const QImage &image, const QRectF &srcRect, const QString &tmpFile,
+                                std::function<void()> release)
+{
+    const QSize snapSize = snapshotSize();
+    const QSizeF targetSize(snapSize);
+    QSharedPointer<QAtomicInteger<quint64>> fetchSerial = m_fetchSerial;
+
+    QFutureWatcher<SnapshotResult> *watcher = new QFutureWatcher<SnapshotResult>(this);
+    connect(watcher, &QFutureWatcher<SnapshotResult>::finished, this, [ = ] {
+        watcher->deleteLater();
+        if (serial != *m_fetchSerial)
+            return;
+
+        m_fetching = false;
+
+        const SnapshotResult &result = watcher->result();
+        // 如果截图或区域为空，说明三种方式均失败，返回不做处理
+        if (result.image.isNull() || result.srcRect.isNull()) {
+            qWarning() << "can not get QImage or QRectF! giving up...";
+            return;
+        }
+
+        m_snapshot = result.image;
+        m_snapshotSrcRect = result.srcRect;
+        SnapshotCache::instance()->insert(m_wid, snapSize, m_snapshot, m_snapshotSrcRect);
+        update();
+    });
+
+    watcher->setFuture(QtConcurrent::run([ = ] {
+        SnapshotResult result;
+        result.image = image;
+        result.srcRect = srcRect;
+
+        if (!tmpFile.isEmpty()) {
+            result.image.load(tmpFile);
+            result.srcRect = result.image.rect();
+            QFile::remove(tmpFile);
+        }
+
+        // 请求已被取消，不再缩放
+        if (serial == *fetchSerial && !result.image.isNull() && !result.srcRect.isNull()) {
+            const QSizeF size = result.srcRect.size().scaled(targetSize, Qt::KeepAspectRatio);
+            const qreal scale = qreal(size.width()) / result.srcRect.width();
+            result.image = result.image.scaled(qRound(result.image.width() * scale), qRound(result.image.height() * scale),
+                                               Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            result.srcRect.moveTop(result.srcRect.top() * scale + 0.5);
+            result.srcRect.moveLeft(result.srcRect.left() * scale + 0.5);
+            result.srcRect.setWidth(size.width() - 0.5);
+            result.srcRect.setHeight(size.height() - 0.5);
+        } else {
+            result.image = QImage();
+        }
+
+        // image引用的内存释放后不能再使用，大小不变时scaled返回的是同一份数据，需要复制
+        if (release) {
+            if (!result.image.isNull() && result.image.cacheKey() == image.cacheKey())
+                result.image = result.image.copy();
+            release();
+        }
+
+        return result;
+    }));
+}
+
+/**
+ * @brief AppSnapshot::snapshotSize
+ * @return 截图缩放时的目标像素大小
+ */
+QSize AppSnapshot::snapshotSize() const
+{
+    return (QSizeF(rect().marginsRemoved(QMargins(8, 8, 8, 8)).size()) * devicePixelRatioF()).toSize();
+}
+
+void AppSnapshot::cancelFetch()
+{
+    if (!m_fetching)
+        return;
+
+    ++(*m_fetchSerial);
+    m_fetching = false;
+    m_fetchCanceled = true;
 }
 
 void AppSnapshot::enterEvent(QEvent *e)
@@ -376,6 +513,22 @@ void AppSnapshot::resizeEvent(QResizeEvent *event)
     fetchSnapshot();
 }
 
+void AppSnapshot::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+
+    // 隐藏时被取消的截图需要重新获取
+    if (m_fetchCanceled)
+        fetchSnapshot();
+}
+
+void AppSnapshot::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+
+    cancelFetch();
+}
+
 SHMInfo *AppSnapshot::getImageDSHM()
 {
     const auto display = Utils::IS_WAYLAND_DISPLAY ? XOpenDisplay(nullptr) : QX11Info::display();
@@ -490,14 +643,3 @@ void AppSnapshot::getWindowState()
         XFree(properties);
     }
 }
-
-bool AppSnapshot::isKWinAvailable()
-{
-    if (QDBusConnection::sessionBus().interface()->isServiceRegistered(QStringLiteral("org.kde.KWin"))) {
-        QDBusInterface interface(QStringLiteral("org.kde.KWin"), QStringLiteral("/Effects"), QStringLiteral("org.kde.kwin.Effects"));
-        QDBusReply<bool> reply = interface.call(QStringLiteral("isEffectLoaded"), "screenshot");
-
-        return reply.value();
-    }
-    return false;
-}
@@ -8,6 +8,10 @@
 #include <QWidget>
 #include <QDebug>
 #include <QTimer>
+#include <QAtomicInteger>
+#include <QSharedPointer>
+
+#include <functional>
 
 #include <DIconButton>
 #include <DWindowManagerHelper>
@@ -49,6 +53,7 @@ class AppSnapshot : public QWidget
 
 public:
     explicit AppSnapshot(const WId wid, QWidget *parent = 0);
+    ~AppSnapshot() override;
 
     inline WId wid() const { return m_wid; }
     inline bool attentioned() const { return m_windowInfo.attention; }
@@ -60,7 +65,6 @@ public:
     void setWindowState();
     void setTitleVisible(bool bVisible);
     QString appTitle() { return m_3DtitleBtn ? m_3DtitleBtn->text() : QString(); }
-    bool isKWinAvailable();
 
 signals:
     void entered(const WId wid) const;
@@ -82,6 +86,13 @@ private:
     void mousePressEvent(QMouseEvent *e) override;
     bool eventFilter(QObject *watched, QEvent *e) override;
     void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void fetchSnapshotFromKWin(quint64 serial);
+    void fetchSnapshotFromX11(quint64 serial);
+    void scaleSnapshot(quint64 serial, const QImage &image, const QRectF &srcRect, const QString &tmpFile, std::function<void()> release);
+    QSize snapshotSize() const;
+    void cancelFetch();
     SHMInfo *getImageDSHM();
     XImage *getImageXlib();
     QRect rectRemovedShadow(const QImage &qimage, unsigned char *prop_to_return_gtk);
@@ -97,6 +108,11 @@ private:
     QImage m_snapshot;
     QRectF m_snapshotSrcRect;
 
+    // 截图请求序号，递增后之前还未完成的请求会被丢弃，工作线程中也会读取
+    QSharedPointer<QAtomicInteger<quint64>> m_fetchSerial;
+    bool m_fetching;
+    bool m_fetchCanceled;
+
     Dock::TipsWidget *m_title;
     DPushButton *m_3DtitleBtn;
 
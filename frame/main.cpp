@@ -9,6 +9,8 @@
 #include "themeappicon.h"
 #include "dockitemmanager.h"
 #include "dockapplication.h"
+#include "startuptracer.h"
+#include "icondiskcache.h"
 
 #include <QAccessible>
 #include <QDir>
@@ -150,13 +152,20 @@ bool IsSaveMode()
 
 int main(int argc, char *argv[])
 {
+    const qint64 startTime = QDateTime::currentMSecsSinceEpoch();
+    StartupTracer *tracer = StartupTracer::instance();
+
     if (QString(getenv("XDG_CURRENT_DESKTOP")).compare("deepin", Qt::CaseInsensitive) == 0) {
         qDebug() << "Warning: force enable D_DXCB_FORCE_NO_TITLEBAR now!";
         setenv("D_DXCB_FORCE_NO_TITLEBAR", "1", 1);
     }
 
     DGuiApplicationHelper::setAttribute(DGuiApplicationHelper::UseInactiveColorGroup, false);
+    qint64 traceBegin = tracer->now();
     DockApplication app(argc, argv);
+    app.setProperty("START_TIME", startTime);
+    tracer->addEvent("DockApplication", QString(), "startup", traceBegin, tracer->now());
+    QObject::connect(&app, &QApplication::aboutToQuit, [ = ] { tracer->dumpToEnvFile(); });
 
     //崩溃信号
     signal(SIGSEGV, sig_crash);
@@ -202,9 +211,14 @@ int main(int argc, char *argv[])
     QDir::setCurrent(QApplication::applicationDirPath());
 #endif
 
+    // 在加载插件前创建，托盘插件通过qApp的属性共用这个实例
+    IconDiskCache::instance();
+
     // 注册任务栏的DBus服务
+    traceBegin = tracer->now();
     MainWindow mw;
     DBusDockAdaptors adaptor(&mw);
+    tracer->addEvent("MainWindow", QString(), "startup", traceBegin, tracer->now());
 
     if(Utils::IS_WAYLAND_DISPLAY) {
         mw.setAttribute(Qt::WA_NativeWindow);
@@ -4,15 +4,21 @@
 
 #include "abstractpluginscontroller.h"
 #include "pluginsiteminterface.h"
+#include "pluginmanifest.h"
+#include "pluginstub.h"
+#include "startuptracer.h"
 #include "utils.h"
 
 #include <DNotifySender>
 #include <DSysInfo>
+#include <DConfig>
 
 #include <QDebug>
 #include <QDir>
 #include <QMapIterator>
 
+DCORE_USE_NAMESPACE
+
 static const QStringList CompatiblePluginApiList {
     "1.1.1",
     "1.2",
@@ -25,9 +31,16 @@ AbstractPluginsController::AbstractPluginsController(QObject *parent)
     : QObject(parent)
     , m_dbusDaemonInterface(QDBusConnection::sessionBus().interface())
     , m_dockDaemonInter(new DockDaemonInter("com.deepin.dde.daemon.Dock", "/com/deepin/dde/daemon/Dock", QDBusConnection::sessionBus(), this))
+    , m_lazyLoad(true)
 {
     qApp->installEventFilter(this);
 
+    // 被禁用的插件是否延迟到启用时再加载
+    DConfig *config = DConfig::create("org.deepin.dde.dock", "org.deepin.dde.dock");
+    if (config->isValid() && config->keyList().contains("lazyLoadPlugins"))
+        m_lazyLoad = config->value("lazyLoadPlugins").toBool();
+    delete config;
+
     refreshPluginSettings();
 
     connect(m_dockDaemonInter, &DockDaemonInter::PluginSettingsSynced, this, &AbstractPluginsController::refreshPluginSettings, Qt::QueuedConnection);
@@ -182,19 +195,89 @@ void AbstractPluginsController::positionChanged()
 
 void AbstractPluginsController::loadPlugin(const QString &pluginFile)
 {
-    QPluginLoader *pluginLoader = new QPluginLoader(pluginFile, this);
-    const QJsonObject &meta = pluginLoader->metaData().value("MetaData").toObject();
+    TraceSpan span("loadPlugin", QFileInfo(pluginFile).fileName());
+
+    // 先通过缓存的元数据判断插件是否需要加载，不兼容的插件不会被dlopen
+    PluginManifest *manifest = PluginManifest::instance();
+    const QJsonObject &meta = manifest->metaData(pluginFile).value("MetaData").toObject();
     const QString &pluginApi = meta.value("api").toString();
-    bool pluginIsValid = true;
     if (pluginApi.isEmpty() || !CompatiblePluginApiList.contains(pluginApi)) {
         qDebug() << objectName()
                  << "plugin api version not matched! expect versions:" << CompatiblePluginApiList
                  << ", got version:" << pluginApi
                  << ", the plugin file is:" << pluginFile;
 
-        pluginIsValid = false;
+        removePluginLoadInfo(pluginFile);
+        QString notifyMessage(tr("The plugin %1 is not compatible with the system."));
+        Dtk::Core::DUtil::DNotifySender(notifyMessage.arg(QFileInfo(pluginFile).fileName())).appIcon("dialog-warning").call();
+        return;
+    }
+
+    if (manifest->pluginName(pluginFile) == "multitasking" && Dtk::Core::DSysInfo::deepinType() == Dtk::Core::DSysInfo::DeepinServer) {
+        removePluginLoadInfo(pluginFile);
+        return;
+    }
+
+    // 被禁用的插件先使用占位对象，不加载插件库，启用时再加载
+    if (m_lazyLoad && isPluginDisabled(pluginFile)) {
+        qDebug() << objectName() << "plugin is disabled, load it on demand:" << pluginFile;
+
+        PluginStub *stub = new PluginStub(pluginFile, manifest->pluginName(pluginFile),
+                                          manifest->pluginDisplayName(pluginFile), manifest->pluginType(pluginFile));
+        connect(stub, &PluginStub::activateRequested, this, [ = ](bool switchState) {
+            activatePlugin(stub, switchState);
+        });
+
+        updatePluginLoadInfo(pluginFile, stub);
+        m_pluginsMap.insert(stub, QMap<QString, QObject *>());
+
+        QTimer::singleShot(1, this, [ = ] {
+            initPlugin(stub);
+        });
+        return;
     }
 
+    // 依赖的服务没有启动时，等服务启动后再加载插件
+    const QString &dbusService = meta.value("depends-daemon-dbus-service").toString();
+    if (!dbusService.isEmpty() && !m_dbusDaemonInterface->isServiceRegistered(dbusService).value()) {
+        qDebug() << objectName() << dbusService << "daemon has not started, waiting for signal";
+        QMetaObject::Connection *connection = new QMetaObject::Connection;
+        *connection = connect(m_dbusDaemonInterface, &QDBusConnectionInterface::serviceOwnerChanged, this,
+                [ = ](const QString & name, const QString & oldOwner, const QString & newOwner) {
+            Q_UNUSED(oldOwner);
+            if (name == dbusService && !newOwner.isEmpty()) {
+                qDebug() << objectName() << dbusService << "daemon started, init plugin and disconnect";
+                disconnect(*connection);
+                delete connection;
+                initPlugin(createPlugin(pluginFile));
+            }
+        }
+        );
+        return;
+    }
+
+    PluginsItemInterface *interface = createPlugin(pluginFile);
+    if (!interface)
+        return;
+
+    // NOTE(justforlxz): 插件的所有初始化工作都在init函数中进行，
+    // loadPlugin函数是按队列执行的，initPlugin函数会有可能导致
+    // 函数执行被阻塞。
+    QTimer::singleShot(1, this, [ = ] {
+        initPlugin(interface);
+    });
+}
+
+/**
+ * @brief AbstractPluginsController::createPlugin 加载插件库并创建插件对象
+ * @param pluginFile 插件文件路径
+ * @return 插件对象，加载失败时返回空
+ */
+PluginsItemInterface *AbstractPluginsController::createPlugin(const QString &pluginFile)
+{
+    TraceSpan span("createPlugin", QFileInfo(pluginFile).fileName());
+
+    QPluginLoader *pluginLoader = new QPluginLoader(pluginFile, this);
     PluginsItemInterface *interface = qobject_cast<PluginsItemInterface *>(pluginLoader->instance());
 
     if (!interface) {
@@ -203,29 +286,72 @@ void AbstractPluginsController::loadPlugin(const QString &pluginFile)
         pluginLoader->unload();
         pluginLoader->deleteLater();
 
-        pluginIsValid = false;
-    }
-
-    if (!pluginIsValid) {
-        for (auto &pair : m_pluginLoadMap.keys()) {
-            if (pair.first == pluginFile) {
-                m_pluginLoadMap.remove(pair);
-            }
-        }
+        removePluginLoadInfo(pluginFile);
         QString notifyMessage(tr("The plugin %1 is not compatible with the system."));
         Dtk::Core::DUtil::DNotifySender(notifyMessage.arg(QFileInfo(pluginFile).fileName())).appIcon("dialog-warning").call();
-        return;
+        return nullptr;
     }
 
+    PluginManifest::instance()->setPluginInfo(pluginFile, interface);
+
+    // 第一次加载时缓存中还没有插件名
     if (interface->pluginName() == "multitasking" && Dtk::Core::DSysInfo::deepinType() == Dtk::Core::DSysInfo::DeepinServer) {
-        for (auto &pair : m_pluginLoadMap.keys()) {
-            if (pair.first == pluginFile) {
-                m_pluginLoadMap.remove(pair);
-            }
-        }
-        return;
+        removePluginLoadInfo(pluginFile);
+        return nullptr;
     }
 
+    updatePluginLoadInfo(pluginFile, interface);
+
+    // 保存 PluginLoader 对象指针
+    QMap<QString, QObject *> interfaceData;
+    interfaceData["pluginloader"] = pluginLoader;
+    m_pluginsMap.insert(interface, interfaceData);
+
+    return interface;
+}
+
+/**
+ * @brief AbstractPluginsController::activatePlugin 加载占位对象对应的插件，并替换占位对象
+ * @param stub 占位对象
+ * @param switchState 加载后是否切换插件的启用状态
+ */
+void AbstractPluginsController::activatePlugin(PluginStub *stub, bool switchState)
+{
+    if (!m_pluginsMap.contains(stub))
+        return;
+
+    const QString pluginFile = stub->pluginFile();
+    qDebug() << objectName() << "activate plugin:" << pluginFile;
+
+    m_pluginsMap.remove(stub);
+    stub->disconnect(this);
+    stub->deleteLater();
+
+    PluginsItemInterface *interface = createPlugin(pluginFile);
+    if (!interface)
+        return;
+
+    initPlugin(interface);
+
+    if (switchState && interface->pluginIsDisable())
+        interface->pluginStateSwitched();
+}
+
+/**
+ * @brief AbstractPluginsController::isPluginDisabled 根据缓存的插件信息和插件配置判断插件是否被禁用
+ */
+bool AbstractPluginsController::isPluginDisabled(const QString &pluginFile)
+{
+    PluginManifest *manifest = PluginManifest::instance();
+    const QString &pluginName = manifest->pluginName(pluginFile);
+    if (pluginName.isEmpty() || !manifest->pluginAllowDisable(pluginFile))
+        return false;
+
+    return !m_pluginSettingsObject.value(pluginName).toObject().value("enable").toBool(true);
+}
+
+void AbstractPluginsController::updatePluginLoadInfo(const QString &pluginFile, PluginsItemInterface *interface)
+{
     QMapIterator<QPair<QString, PluginsItemInterface *>, bool> it(m_pluginLoadMap);
     while (it.hasNext()) {
         it.next();
@@ -238,33 +364,15 @@ void AbstractPluginsController::loadPlugin(const QString &pluginFile)
             break;
         }
     }
+}
 
-    // 保存 PluginLoader 对象指针
-    QMap<QString, QObject *> interfaceData;
-    interfaceData["pluginloader"] = pluginLoader;
-    m_pluginsMap.insert(interface, interfaceData);
-    QString dbusService = meta.value("depends-daemon-dbus-service").toString();
-    if (!dbusService.isEmpty() && !m_dbusDaemonInterface->isServiceRegistered(dbusService).value()) {
-        qDebug() << objectName() << dbusService << "daemon has not started, waiting for signal";
-        connect(m_dbusDaemonInterface, &QDBusConnectionInterface::serviceOwnerChanged, this,
-                [ = ](const QString & name, const QString & oldOwner, const QString & newOwner) {
-            Q_UNUSED(oldOwner);
-            if (name == dbusService && !newOwner.isEmpty()) {
-                qDebug() << objectName() << dbusService << "daemon started, init plugin and disconnect";
-                initPlugin(interface);
-                disconnect(m_dbusDaemonInterface);
-            }
+void AbstractPluginsController::removePluginLoadInfo(const QString &pluginFile)
+{
+    for (auto &pair : m_pluginLoadMap.keys()) {
+        if (pair.first == pluginFile) {
+            m_pluginLoadMap.remove(pair);
         }
-        );
-        return;
     }
-
-    // NOTE(justforlxz): 插件的所有初始化工作都在init函数中进行，
-    // loadPlugin函数是按队列执行的，initPlugin函数会有可能导致
-    // 函数执行被阻塞。
-    QTimer::singleShot(1, this, [ = ] {
-        initPlugin(interface);
-    });
 }
 
 void AbstractPluginsController::initPlugin(PluginsItemInterface *interface)
@@ -273,7 +381,10 @@ void AbstractPluginsController::initPlugin(PluginsItemInterface *interface)
         return;
 
     qDebug() << objectName() << "init plugin: " << interface->pluginName();
-    interface->init(this);
+    {
+        TraceSpan span("initPlugin", interface->pluginName());
+        interface->init(this);
+    }
 
     for (const auto &pair : m_pluginLoadMap.keys()) {
         if (pair.second == interface)
@@ -18,6 +18,7 @@
 using DockDaemonInter = com::deepin::dde::daemon::Dock;
 
 class PluginsItemInterface;
+class PluginStub;
 class AbstractPluginsController : public QObject, PluginProxyInterface
 {
     Q_OBJECT
@@ -52,6 +53,11 @@ private slots:
 
 private:
     bool eventFilter(QObject *o, QEvent *e) override;
+    PluginsItemInterface *createPlugin(const QString &pluginFile);
+    void activatePlugin(PluginStub *stub, bool switchState);
+    bool isPluginDisabled(const QString &pluginFile);
+    void updatePluginLoadInfo(const QString &pluginFile, PluginsItemInterface *interface);
+    void removePluginLoadInfo(const QString &pluginFile);
 
 private:
     QDBusConnectionInterface *m_dbusDaemonInterface;
@@ -64,6 +70,7 @@ private:
     QMap<QPair<QString, PluginsItemInterface *>, bool> m_pluginLoadMap;
 
     QJsonObject m_pluginSettingsObject;
+    bool m_lazyLoad;
 };
 
 #endif // ABSTRACTPLUGINSCONTROLLER_H
@@ -0,0 +1,222 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "cursoredgemonitor.h"
+#include "utils.h"
+
+#include <QScopedPointer>
+#include <QDebug>
+
+#include <xcb/xinput.h>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// 鼠标停留在唤醒区域内时，最多每隔这么久再通知一次，用于唤醒时正好在播放动画等被忽略的情况
+#define WAKE_REPEAT_INTERVAL 100
+
+CursorEdgeMonitor::CursorEdgeMonitor(QObject *parent)
+    : QThread(parent)
+    , m_areasChanged(false)
+    , m_wakeArea(-1)
+    , m_dockArea(-1)
+    , m_connection(nullptr)
+    , m_wakeFd(-1)
+    , m_xiOpcode(0)
+    , m_running(0)
+{
+}
+
+CursorEdgeMonitor::~CursorEdgeMonitor()
+{
+    stop();
+}
+
+/**
+ * @brief CursorEdgeMonitor::start 打开单独的X连接并监听RawMotion事件
+ * @return 不支持时返回false，此时需要使用XEventMonitor
+ */
+bool CursorEdgeMonitor::start()
+{
+    if (isRunning())
+        return true;
+
+    if (Utils::IS_WAYLAND_DISPLAY)
+        return false;
+
+    xcb_connection_t *c = xcb_connect(nullptr, nullptr);
+    if (xcb_connection_has_error(c)) {
+        xcb_disconnect(c);
+        return false;
+    }
+
+    const xcb_query_extension_reply_t *extension = xcb_get_extension_data(c, &xcb_input_id);
+    QScopedPointer<xcb_input_xi_query_version_reply_t, QScopedPointerPodDeleter> version;
+    if (extension && extension->present)
+        version.reset(xcb_input_xi_query_version_reply(c, xcb_input_xi_query_version(c, 2, 0), nullptr));
+
+    if (!version || version->major_version < 2) {
+        qInfo() << "XInput2 is not supported, cursor edge monitor disabled";
+        xcb_disconnect(c);
+        return false;
+    }
+
+    struct {
+        xcb_input_event_mask_t head;
+        uint32_t mask;
+    } mask;
+    mask.head.deviceid = XCB_INPUT_DEVICE_ALL_MASTER;
+    mask.head.mask_len = 1;
+    mask.mask = XCB_INPUT_XI_EVENT_MASK_RAW_MOTION;
+
+    // RawMotion只能在根窗口上监听，和鼠标所在的窗口无关
+    xcb_screen_t *screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+    xcb_input_xi_select_events(c, screen->root, 1, &mask.head);
+    xcb_flush(c);
+
+    // 退出或区域变化时唤醒线程
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeFd < 0) {
+        qWarning() << "create eventfd failed, cursor edge monitor disabled";
+        xcb_disconnect(c);
+        return false;
+    }
+
+    m_connection = c;
+    m_xiOpcode = extension->major_opcode;
+    m_running = 1;
+
+    QThread::start();
+
+    return true;
+}
+
+void CursorEdgeMonitor::stop()
+{
+    if (!isRunning())
+        return;
+
+    m_running = 0;
+    wake();
+    wait();
+
+    xcb_disconnect(m_connection);
+    m_connection = nullptr;
+
+    ::close(m_wakeFd);
+    m_wakeFd = -1;
+}
+
+void CursorEdgeMonitor::wake()
+{
+    if (m_wakeFd >= 0)
+        eventfd_write(m_wakeFd, 1);
+}
+
+/**
+ * @brief CursorEdgeMonitor::setAreas 更新监听的区域，在主线程中调用
+ * @param wakeAreas 唤醒任务栏的区域
+ * @param dockAreas 任务栏所在的区域，鼠标移出后任务栏需要隐藏
+ */
+void CursorEdgeMonitor::setAreas(const QList<QRect> &wakeAreas, const QList<QRect> &dockAreas)
+{
+    QMutexLocker locker(&m_mutex);
+    m_wakeAreas = wakeAreas;
+    m_dockAreas = dockAreas;
+    m_areasChanged = true;
+    locker.unlock();
+
+    wake();
+}
+
+int CursorEdgeMonitor::areaAt(const QList<QRect> &areas, const QPoint &pos)
+{
+    for (int i = 0; i < areas.size(); ++i) {
+        if (areas.at(i).contains(pos))
+            return i;
+    }
+
+    return -1;
+}
+
+void CursorEdgeMonitor::run()
+{
+    xcb_connection_t *c = m_connection;
+    xcb_window_t root = xcb_setup_roots_iterator(xcb_get_setup(c)).data->root;
+
+    pollfd fds[2];
+    fds[0].fd = xcb_get_file_descriptor(c);
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    while (m_running && !xcb_connection_has_error(c)) {
+        // 查询鼠标位置时可能已经把事件读入了xcb的队列，队列为空时才等待，不需要超时
+        xcb_generic_event_t *event = xcb_poll_for_queued_event(c);
+        if (!event) {
+            fds[0].revents = fds[1].revents = 0;
+            poll(fds, 2, -1);
+
+            if (fds[1].revents & POLLIN) {
+                eventfd_t value;
+                eventfd_read(m_wakeFd, &value);
+            }
+
+            event = xcb_poll_for_event(c);
+        }
+
+        // 一批事件只查询一次鼠标位置
+        bool moved = false;
+        while (event) {
+            if ((event->response_type & ~0x80) == XCB_GE_GENERIC) {
+                xcb_ge_generic_event_t *ge = reinterpret_cast<xcb_ge_generic_event_t *>(event);
+                if (ge->extension == m_xiOpcode && ge->event_type == XCB_INPUT_RAW_MOTION)
+                    moved = true;
+            }
+            free(event);
+            event = xcb_poll_for_event(c);
+        }
+
+        bool areasChanged = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            areasChanged = m_areasChanged;
+        }
+
+        if (!moved && !areasChanged)
+            continue;
+
+        QScopedPointer<xcb_query_pointer_reply_t, QScopedPointerPodDeleter> pointer(xcb_query_pointer_reply(c, xcb_query_pointer(c, root), nullptr));
+        if (pointer)
+            updatePosition(QPoint(pointer->root_x, pointer->root_y));
+    }
+}
+
+void CursorEdgeMonitor::updatePosition(const QPoint &pos)
+{
+    QMutexLocker locker(&m_mutex);
+    const int wakeArea = areaAt(m_wakeAreas, pos);
+    const int dockArea = areaAt(m_dockAreas, pos);
+
+    // 区域变化后只更新鼠标所在的区域，不通知
+    if (m_areasChanged) {
+        m_areasChanged = false;
+        m_wakeArea = wakeArea;
+        m_dockArea = dockArea;
+        return;
+    }
+    locker.unlock();
+
+    if (wakeArea >= 0 && (wakeArea != m_wakeArea || !m_lastWake.isValid() || m_lastWake.elapsed() >= WAKE_REPEAT_INTERVAL)) {
+        m_lastWake.start();
+        Q_EMIT wakeAreaEntered(pos.x(), pos.y());
+    }
+
+    if (m_dockArea >= 0 && dockArea < 0)
+        Q_EMIT dockAreaLeft(pos.x(), pos.y());
+
+    m_wakeArea = wakeArea;
+    m_dockArea = dockArea;
+}
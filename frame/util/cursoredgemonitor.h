@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef CURSOREDGEMONITOR_H
+#define CURSOREDGEMONITOR_H
+
+#include <QThread>
+#include <QMutex>
+#include <QList>
+#include <QRect>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+#include <xcb/xcb.h>
+
+/**
+ * @brief The CursorEdgeMonitor class
+ * @note 在单独的线程中通过XInput2的RawMotion事件跟踪鼠标，代替XEventMonitor的D-Bus信号判断鼠标是否进入唤醒区域，
+ * @note 只有进入、离开区域时才通知主线程。区域使用X的原始坐标(未缩放)，不支持XInput2(如wayland)时start返回false
+ */
+class CursorEdgeMonitor : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit CursorEdgeMonitor(QObject *parent = nullptr);
+    ~CursorEdgeMonitor() override;
+
+    bool start();
+    void stop();
+
+    void setAreas(const QList<QRect> &wakeAreas, const QList<QRect> &dockAreas);
+
+    static int areaAt(const QList<QRect> &areas, const QPoint &pos);
+
+Q_SIGNALS:
+    // 进入唤醒区域，或者在不同屏幕的唤醒区域之间移动
+    void wakeAreaEntered(int x, int y);
+    // 从任务栏区域移出
+    void dockAreaLeft(int x, int y);
+
+protected:
+    void run() override;
+
+private:
+    void updatePosition(const QPoint &pos);
+    void wake();
+
+private:
+    QMutex m_mutex;
+    QList<QRect> m_wakeAreas;
+    QList<QRect> m_dockAreas;
+    // 区域变化后需要重新计算鼠标所在的区域
+    bool m_areasChanged;
+
+    int m_wakeArea;                 // 鼠标所在的唤醒区域，不在任何区域时为-1
+    int m_dockArea;                 // 鼠标所在的任务栏区域，不在任何区域时为-1
+
+    xcb_connection_t *m_connection;
+    int m_wakeFd;                   // eventfd，退出或区域变化时唤醒线程
+    QElapsedTimer m_lastWake;       // 在唤醒区域内移动时限制通知的频率
+    quint8 m_xiOpcode;
+    QAtomicInt m_running;
+};
+
+#endif // CURSOREDGEMONITOR_H
@@ -0,0 +1,460 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "icondiskcache.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QIcon>
+#include <QStandardPaths>
+#include <QSaveFile>
+#include <QTimer>
+#include <QDebug>
+
+#include <DApplication>
+
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <functional>
+
+DWIDGET_USE_NAMESPACE
+
+// 缓存文件格式变化时需要修改版本号，旧文件会被直接清空
+#define CACHE_MAGIC "DDIC"
+#define CACHE_VERSION 1
+#define CACHE_HEADER_SIZE 16
+#define CACHE_MAX_SIZE (64 * 1024 * 1024)
+// 启动时会连续获取很多图标，合并后再写入文件
+#define CACHE_FLUSH_INTERVAL 1000
+#define CACHE_PROPERTY "_d_dock_icon_disk_cache"
+
+/**
+ * 文件格式(本机字节序)：
+ * 文件头: magic(4) version(4) reserved(8)
+ * 记录:   keyLength(4) key(按4字节对齐) width(4) height(4) bytesPerLine(4) pixels(bytesPerLine * height)
+ */
+static inline quint32 alignedSize(quint32 size)
+{
+    return (size + 3) & ~quint32(3);
+}
+
+static inline quint32 readUInt32(const uchar *data)
+{
+    quint32 value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline void appendUInt32(QByteArray &data, quint32 value)
+{
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static QByteArray fileHeader()
+{
+    QByteArray header(CACHE_MAGIC);
+    appendUInt32(header, CACHE_VERSION);
+    header.append(QByteArray(CACHE_HEADER_SIZE - header.size(), '\0'));
+    return header;
+}
+
+static inline bool isValidHeader(const uchar *data, qint64 size)
+{
+    return data && size >= CACHE_HEADER_SIZE && memcmp(data, CACHE_MAGIC, 4) == 0 && readUInt32(data + 4) == CACHE_VERSION;
+}
+
+/**
+ * @brief forEachRecord 遍历文件中所有完整的记录
+ * @param func 参数依次为键值、记录的起始位置、图像数据头的位置、记录的结束位置
+ * @return 最后一条完整记录的结束位置
+ */
+static qint64 forEachRecord(const uchar *data, qint64 size, std::function<void(const QByteArray &, qint64, qint64, qint64)> func)
+{
+    qint64 offset = CACHE_HEADER_SIZE;
+    while (offset + 4 <= size) {
+        const quint32 keyLength = readUInt32(data + offset);
+        const qint64 headerOffset = offset + 4 + alignedSize(keyLength);
+        if (keyLength == 0 || headerOffset + 12 > size)
+            break;
+
+        const quint32 height = readUInt32(data + headerOffset + 4);
+        const quint32 bytesPerLine = readUInt32(data + headerOffset + 8);
+        const qint64 recordEnd = headerOffset + 12 + qint64(bytesPerLine) * height;
+        if (recordEnd > size)
+            break;
+
+        func(QByteArray(reinterpret_cast<const char *>(data + offset + 4), int(keyLength)), offset, headerOffset, recordEnd);
+        offset = recordEnd;
+    }
+
+    return offset;
+}
+
+/**
+ * @brief recordThemeKey
+ * @return 记录键值中的主题键值，键值格式见IconDiskCache::cacheKey
+ */
+static inline QString recordThemeKey(const QByteArray &key)
+{
+    return QString::fromUtf8(key).section('|', -3, -3);
+}
+
+/**
+ * @brief The FileLocker class
+ * @note 任务栏和托盘插件中各有一个实例会写同一个文件，读写时需要加文件锁
+ */
+class FileLocker
+{
+public:
+    explicit FileLocker(int fd) : m_fd(fd) { flock(m_fd, LOCK_EX); }
+    ~FileLocker() { flock(m_fd, LOCK_UN); }
+
+private:
+    int m_fd;
+};
+
+IconDiskCache::IconDiskCache(const QString &key, QObject *parent)
+    : QObject(parent)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_appendedSize(0)
+    , m_flushTimer(new QTimer(this))
+    , m_themeKey(key)
+    , m_hits(0)
+    , m_misses(0)
+{
+    load();
+
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(CACHE_FLUSH_INTERVAL);
+    connect(m_flushTimer, &QTimer::timeout, this, &IconDiskCache::flushPending);
+    if (qApp)
+        connect(qApp, &QCoreApplication::aboutToQuit, this, &IconDiskCache::flushPending);
+
+    DApplication *app = qobject_cast<DApplication *>(qApp);
+    if (app) {
+        connect(app, &DApplication::iconThemeChanged, this, &IconDiskCache::onIconThemeChanged);
+    }
+}
+
+IconDiskCache::~IconDiskCache()
+{
+    flushPending();
+}
+
+/**
+ * @brief IconDiskCache::instance
+ * @note 托盘插件中也会编译这个文件，通过qApp的属性共享任务栏进程中的实例，避免两个实例同时读写同一个文件
+ */
+IconDiskCache *IconDiskCache::instance()
+{
+    static IconDiskCache *cache = nullptr;
+    if (cache)
+        return cache;
+
+    const QVariant &value = qApp->property(CACHE_PROPERTY);
+    if (value.isValid()) {
+        cache = reinterpret_cast<IconDiskCache *>(value.value<quintptr>());
+    } else {
+        cache = new IconDiskCache;
+        qApp->setProperty(CACHE_PROPERTY, QVariant::fromValue(reinterpret_cast<quintptr>(cache)));
+    }
+
+    return cache;
+}
+
+/**
+ * @brief IconDiskCache::find 从缓存中查找已经光栅化的图标
+ * @param iconName 图标名
+ * @param pixelSize 图标的实际像素大小
+ * @param ratio 缩放比例
+ * @param pix 找到时保存图标
+ * @return 是否找到
+ */
+bool IconDiskCache::find(const QString &iconName, int pixelSize, qreal ratio, QPixmap &pix)
+{
+    if (m_themeKey.isEmpty())
+        return false;
+
+    const QByteArray &key = cacheKey(iconName, pixelSize, ratio);
+
+    auto appendedIt = m_appended.constFind(key);
+    if (appendedIt != m_appended.constEnd()) {
+        pix = QPixmap::fromImage(appendedIt.value());
+        pix.setDevicePixelRatio(ratio);
+        ++m_hits;
+        return true;
+    }
+
+    auto it = m_index.constFind(key);
+    if (it == m_index.constEnd() || !m_data) {
+        ++m_misses;
+        return false;
+    }
+
+    const uchar *header = m_data + it.value();
+    const int width = int(readUInt32(header));
+    const int height = int(readUInt32(header + 4));
+    const int bytesPerLine = int(readUInt32(header + 8));
+
+    // 直接使用映射的内存构造QImage，不需要解析svg
+    // 格式相同时QPixmap会引用原来的数据，文件重新生成后映射会被释放，这里需要复制一份
+    const QImage image(header + 12, width, height, bytesPerLine, QImage::Format_ARGB32_Premultiplied);
+    pix = QPixmap::fromImage(image.copy());
+    pix.setDevicePixelRatio(ratio);
+    ++m_hits;
+
+    return !pix.isNull();
+}
+
+/**
+ * @brief IconDiskCache::insert 保存光栅化后的图标，合并后再追加到缓存文件中
+ */
+void IconDiskCache::insert(const QString &iconName, int pixelSize, qreal ratio, const QPixmap &pix)
+{
+    if (m_themeKey.isEmpty() || !m_file.isOpen() || pix.isNull())
+        return;
+
+    const QByteArray &key = cacheKey(iconName, pixelSize, ratio);
+    if (m_index.contains(key) || m_appended.contains(key))
+        return;
+
+    const QImage &image = pix.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    QByteArray record;
+    record.reserve(int(16 + alignedSize(quint32(key.size())) + image.sizeInBytes()));
+    appendUInt32(record, quint32(key.size()));
+    record.append(key);
+    record.append(QByteArray(int(alignedSize(quint32(key.size())) - quint32(key.size())), '\0'));
+    appendUInt32(record, quint32(image.width()));
+    appendUInt32(record, quint32(image.height()));
+    appendUInt32(record, quint32(image.bytesPerLine()));
+    record.append(reinterpret_cast<const char *>(image.constBits()), int(image.sizeInBytes()));
+
+    // 文件已满时只保留当前主题的记录重新生成，仍然放不下时不再写入
+    if (m_appendedSize + record.size() > CACHE_MAX_SIZE) {
+        rewrite(true);
+        if (!m_file.isOpen() || m_appendedSize + record.size() > CACHE_MAX_SIZE)
+            return;
+    }
+
+    m_appended.insert(key, image);
+    m_pending << qMakePair(key, record);
+    m_appendedSize += record.size();
+
+    if (!m_flushTimer->isActive())
+        m_flushTimer->start();
+}
+
+/**
+ * @brief IconDiskCache::flushPending 将新的图标一次性追加到缓存文件中
+ */
+void IconDiskCache::flushPending()
+{
+    m_flushTimer->stop();
+
+    const QVector<QPair<QByteArray, QByteArray>> pending = m_pending;
+    m_pending.clear();
+    if (pending.isEmpty() || !m_file.isOpen())
+        return;
+
+    // 文件已经被替换时，追加到旧文件的记录不会再被读取，重新打开后再写入
+    if (isFileReplaced()) {
+        const QHash<QByteArray, QImage> appended = m_appended;
+        closeFile();
+        load();
+        if (!m_file.isOpen())
+            return;
+
+        for (const auto &item : pending) {
+            if (!m_index.contains(item.first) && recordThemeKey(item.first) == m_themeKey)
+                m_appended.insert(item.first, appended.value(item.first));
+        }
+    }
+
+    QByteArray data;
+    for (const auto &item : pending) {
+        if (m_appended.contains(item.first) && !m_index.contains(item.first))
+            data.append(item.second);
+    }
+
+    if (data.isEmpty())
+        return;
+
+    {
+        FileLocker locker(m_file.handle());
+        if (!m_file.seek(m_file.size()) || m_file.write(data) != data.size()) {
+            qWarning() << "write icon cache failed:" << m_file.errorString();
+            return;
+        }
+    }
+
+    m_appendedSize = qMax(m_appendedSize, m_file.size());
+}
+
+/**
+ * @brief IconDiskCache::isFileReplaced
+ * @return 打开的文件是否已经被删除或者被新的文件替换
+ */
+bool IconDiskCache::isFileReplaced() const
+{
+    struct stat fileStat;
+    struct stat pathStat;
+    if (fstat(m_file.handle(), &fileStat) != 0 || stat(QFile::encodeName(cacheFilePath()).constData(), &pathStat) != 0)
+        return true;
+
+    return fileStat.st_ino != pathStat.st_ino || fileStat.st_dev != pathStat.st_dev;
+}
+
+QString IconDiskCache::cacheFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/dde-dock/icon-cache.bin";
+}
+
+/**
+ * @brief IconDiskCache::onIconThemeChanged 图标主题变化后更新主题键值，并从文件中去掉旧主题的缓存
+ */
+void IconDiskCache::onIconThemeChanged()
+{
+    const QString &key = themeKey();
+    if (key == m_themeKey)
+        return;
+
+    // 去掉旧主题的记录，避免文件只增不减
+    m_themeKey = key;
+    rewrite(true);
+}
+
+/**
+ * @brief IconDiskCache::load 打开并映射缓存文件，建立键值索引
+ * @param rewriteIfNeeded 文件无效、末尾有不完整的记录或者有其他主题的记录时是否重新生成文件
+ */
+void IconDiskCache::load(bool rewriteIfNeeded)
+{
+    const QString &filePath = cacheFilePath();
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        qWarning() << "open icon cache failed:" << filePath << m_file.errorString();
+        return;
+    }
+
+    bool needsRewrite = false;
+    {
+        FileLocker locker(m_file.handle());
+
+        m_size = m_file.size();
+        if (m_size >= CACHE_HEADER_SIZE && m_size <= CACHE_MAX_SIZE)
+            m_data = m_file.map(0, m_size);
+
+        if (isValidHeader(m_data, m_size)) {
+            bool hasStale = false;
+            const qint64 end = forEachRecord(m_data, m_size, [ & ](const QByteArray &key, qint64, qint64 headerOffset, qint64) {
+                m_index.insert(key, headerOffset);
+                hasStale = hasStale || recordThemeKey(key) != m_themeKey;
+            });
+
+            // 上次写入时被中断，或者有其他主题（包括主题修改时间变化前）的记录
+            needsRewrite = end < m_size || (hasStale && !m_themeKey.isEmpty());
+        } else {
+            needsRewrite = true;
+        }
+    }
+
+    m_appendedSize = m_size;
+
+    if (!needsRewrite)
+        return;
+
+    if (rewriteIfNeeded) {
+        rewrite(isValidHeader(m_data, m_size));
+    } else if (!isValidHeader(m_data, m_size)) {
+        qWarning() << "icon cache is invalid:" << filePath;
+        closeFile();
+    }
+}
+
+void IconDiskCache::closeFile()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar *>(m_data));
+
+    m_data = nullptr;
+    m_file.close();
+    m_index.clear();
+    m_appended.clear();
+    m_size = m_appendedSize = 0;
+}
+
+/**
+ * @brief IconDiskCache::rewrite 重新生成缓存文件
+ * @param keepRecords 是否保留当前主题的完整记录，否则只写入文件头
+ * @note 写入新文件后替换，不在原文件上截断，其他进程已经映射的旧文件不会因为被截断而访问越界
+ */
+void IconDiskCache::rewrite(bool keepRecords)
+{
+    // 先写入内存中的记录，和文件中的记录一起筛选
+    flushPending();
+
+    QByteArray content = fileHeader();
+
+    if (keepRecords && m_file.isOpen()) {
+        // 重新映射整个文件，包含其他进程追加的记录
+        FileLocker locker(m_file.handle());
+        const qint64 size = m_file.size();
+        uchar *data = (size >= CACHE_HEADER_SIZE && size <= CACHE_MAX_SIZE) ? m_file.map(0, size) : nullptr;
+        if (isValidHeader(data, size)) {
+            forEachRecord(data, size, [ & ](const QByteArray &key, qint64 offset, qint64, qint64 end) {
+                if (recordThemeKey(key) == m_themeKey)
+                    content.append(reinterpret_cast<const char *>(data + offset), int(end - offset));
+            });
+        }
+        if (data)
+            m_file.unmap(data);
+    }
+
+    // 当前主题的记录已经超过一半时全部清空，避免每次写入都重新生成
+    if (content.size() > CACHE_MAX_SIZE / 2)
+        content = fileHeader();
+
+    QSaveFile file(cacheFilePath());
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size() || !file.commit())
+        qWarning() << "rewrite icon cache failed:" << file.errorString();
+
+    closeFile();
+    load(false);
+}
+
+QByteArray IconDiskCache::cacheKey(const QString &iconName, int pixelSize, qreal ratio) const
+{
+    return QString("%1|%2|%3|%4").arg(iconName).arg(m_themeKey).arg(pixelSize).arg(ratio).toUtf8();
+}
+
+/**
+ * @brief IconDiskCache::themeKey
+ * @return 主题名和主题目录的最后修改时间，安装或卸载图标后(gtk-update-icon-cache会更新缓存文件)键值会改变
+ */
+QString IconDiskCache::themeKey()
+{
+    const QString &themeName = QIcon::themeName();
+    if (themeName.isEmpty())
+        return QString();
+
+    qint64 lastModified = 0;
+    for (const QString &searchPath : QIcon::themeSearchPaths()) {
+        for (const QString &name : QStringList { themeName, "hicolor" }) {
+            const QString &themeDir = searchPath + "/" + name;
+            for (const QString &file : QStringList { themeDir, themeDir + "/index.theme", themeDir + "/icon-theme.cache" }) {
+                const QFileInfo info(file);
+                if (info.exists())
+                    lastModified = qMax(lastModified, info.lastModified().toMSecsSinceEpoch());
+            }
+        }
+    }
+
+    return QString("%1@%2").arg(themeName).arg(lastModified);
+}
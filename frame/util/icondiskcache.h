@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef ICONDISKCACHE_H
+#define ICONDISKCACHE_H
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QPair>
+#include <QImage>
+#include <QPixmap>
+
+class QTimer;
+
+/**
+ * @brief The IconDiskCache class
+ * @note 将主题图标光栅化后的结果(预乘ARGB32)保存到$XDG_CACHE_HOME/dde-dock下，启动时通过mmap直接读取，
+ * @note 缓存以(图标名, 主题名, 主题修改时间, 像素大小, 缩放比例)作为键值，图标主题变化时自动失效
+ * @note 新的图标先保存在内存中，合并后再写入文件
+ */
+class IconDiskCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static IconDiskCache *instance();
+    ~IconDiskCache() override;
+
+    bool find(const QString &iconName, int pixelSize, qreal ratio, QPixmap &pix);
+    void insert(const QString &iconName, int pixelSize, qreal ratio, const QPixmap &pix);
+
+    int hits() const { return m_hits; }
+    int misses() const { return m_misses; }
+
+    static QString cacheFilePath();
+
+public Q_SLOTS:
+    void onIconThemeChanged();
+    void flushPending();
+
+private:
+    explicit IconDiskCache(const QString &key = IconDiskCache::themeKey(), QObject *parent = nullptr);
+
+    void load(bool rewriteIfNeeded = true);
+    void closeFile();
+    void rewrite(bool keepRecords);
+    bool isFileReplaced() const;
+    QByteArray cacheKey(const QString &iconName, int pixelSize, qreal ratio) const;
+    static QString themeKey();
+
+private:
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    qint64 m_appendedSize;
+
+    QHash<QByteArray, qint64> m_index;          // 键值 -> 映射文件中图像数据的偏移
+    QHash<QByteArray, QImage> m_appended;       // 本次运行中新写入的图标，不在已映射的区域内
+    QVector<QPair<QByteArray, QByteArray>> m_pending;   // 还没有写入文件的(键值, 记录)
+    QTimer *m_flushTimer;
+    QString m_themeKey;
+
+    int m_hits;
+    int m_misses;
+};
+
+#endif // ICONDISKCACHE_H
@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "iconframecache.h"
+
+// 托盘图标按2倍缩放约为6K一帧，1M足够所有托盘保存各自常用的几帧
+#define ICON_FRAME_CACHE_BUDGET (1024 * 1024)
+
+QList<IconFrameCache *> IconFrameCache::Caches;
+qint64 IconFrameCache::TotalBytes = 0;
+qint64 IconFrameCache::Budget = ICON_FRAME_CACHE_BUDGET;
+quint64 IconFrameCache::UseCounter = 0;
+
+IconFrameCache::IconFrameCache(int capacity)
+    : m_capacity(qMax(1, capacity))
+    , m_bytes(0)
+{
+    Caches.append(this);
+}
+
+IconFrameCache::~IconFrameCache()
+{
+    clear();
+    Caches.removeOne(this);
+}
+
+/**
+ * @brief IconFrameCache::find 查找缓存的帧
+ * @param key 由图标的来源(图标名称、图片内容、大小等)生成，来源变化时不能命中
+ * @return 命中时返回true
+ */
+bool IconFrameCache::find(const QByteArray &key, QPixmap &pixmap)
+{
+    for (Frame &frame : m_frames) {
+        if (frame.key != key)
+            continue;
+
+        frame.lastUsed = ++UseCounter;
+        pixmap = frame.pixmap;
+        return true;
+    }
+
+    return false;
+}
+
+void IconFrameCache::insert(const QByteArray &key, const QPixmap &pixmap)
+{
+    if (pixmap.isNull())
+        return;
+
+    for (int i = 0; i < m_frames.size(); ++i) {
+        if (m_frames.at(i).key == key) {
+            removeAt(i);
+            break;
+        }
+    }
+
+    // 超出帧数时替换本实例中最久未使用的帧
+    while (m_frames.size() >= m_capacity) {
+        int oldest = 0;
+        for (int i = 1; i < m_frames.size(); ++i) {
+            if (m_frames.at(i).lastUsed < m_frames.at(oldest).lastUsed)
+                oldest = i;
+        }
+        removeAt(oldest);
+    }
+
+    const qint64 bytes = qint64(pixmap.width()) * pixmap.height() * 4;
+    m_frames.append({key, pixmap, bytes, ++UseCounter});
+    m_bytes += bytes;
+    TotalBytes += bytes;
+
+    trim();
+}
+
+void IconFrameCache::clear()
+{
+    TotalBytes -= m_bytes;
+    m_bytes = 0;
+    m_frames.clear();
+}
+
+void IconFrameCache::setBudget(qint64 budget)
+{
+    Budget = budget;
+    trim();
+}
+
+void IconFrameCache::removeAt(int index)
+{
+    const qint64 bytes = m_frames.at(index).bytes;
+    m_bytes -= bytes;
+    TotalBytes -= bytes;
+    m_frames.removeAt(index);
+}
+
+/**
+ * @brief IconFrameCache::trim 超出内存上限时，在所有实例中淘汰最久未使用的帧
+ */
+void IconFrameCache::trim()
+{
+    while (TotalBytes > Budget) {
+        IconFrameCache *oldestCache = nullptr;
+        int oldestIndex = -1;
+        for (IconFrameCache *cache : Caches) {
+            for (int i = 0; i < cache->m_frames.size(); ++i) {
+                if (!oldestCache || cache->m_frames.at(i).lastUsed < oldestCache->m_frames.at(oldestIndex).lastUsed) {
+                    oldestCache = cache;
+                    oldestIndex = i;
+                }
+            }
+        }
+
+        if (!oldestCache)
+            break;
+
+        oldestCache->removeAt(oldestIndex);
+    }
+}
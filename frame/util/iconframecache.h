@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef ICONFRAMECACHE_H
+#define ICONFRAMECACHE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QPixmap>
+
+/**
+ * @brief The IconFrameCache class
+ * @note 每个托盘图标持有一个，保存最近使用的几帧已经缩放好的图标(普通、提醒、叠加图标等)，
+ * @note 在这几帧之间切换时不需要重新解码和缩放。所有实例共用一个内存上限，超出时淘汰全局最久未使用的帧
+ * @note 只能在主线程中使用
+ */
+class IconFrameCache
+{
+public:
+    explicit IconFrameCache(int capacity = 4);
+    ~IconFrameCache();
+
+    bool find(const QByteArray &key, QPixmap &pixmap);
+    void insert(const QByteArray &key, const QPixmap &pixmap);
+    void clear();
+
+    int count() const { return m_frames.size(); }
+    qint64 bytes() const { return m_bytes; }
+
+    static qint64 totalBytes() { return TotalBytes; }
+    static qint64 budget() { return Budget; }
+    static void setBudget(qint64 budget);
+
+private:
+    struct Frame {
+        QByteArray key;
+        QPixmap pixmap;
+        qint64 bytes;
+        quint64 lastUsed;
+    };
+
+    void removeAt(int index);
+    static void trim();
+
+private:
+    QList<Frame> m_frames;
+    int m_capacity;
+    qint64 m_bytes;
+
+    static QList<IconFrameCache *> Caches;
+    static qint64 TotalBytes;
+    static qint64 Budget;
+    static quint64 UseCounter;
+};
+
+#endif // ICONFRAMECACHE_H
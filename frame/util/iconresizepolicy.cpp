@@ -0,0 +1,86 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "iconresizepolicy.h"
+
+#include <QApplication>
+#include <QTimer>
+
+// 大小停止变化多久之后再重新渲染
+#define SETTLE_INTERVAL 100
+
+// 渲染档位，超出后按照64的倍数向上取整
+static const int SizeBuckets[] = { 16, 24, 32, 48, 64, 96, 128, 192, 256 };
+
+IconResizePolicy::IconResizePolicy(QObject *owner, std::function<void()> refresh)
+    : m_settleTimer(new QTimer(owner))
+    , m_refresh(refresh)
+{
+    m_settleTimer->setSingleShot(true);
+    m_settleTimer->setInterval(SETTLE_INTERVAL);
+
+    QObject::connect(m_settleTimer, &QTimer::timeout, m_settleTimer, [ this ] {
+        if (isResizing())
+            m_settleTimer->start();
+        else
+            m_refresh();
+    });
+}
+
+IconResizePolicy::~IconResizePolicy()
+{
+    delete m_settleTimer;
+}
+
+/**
+ * @brief IconResizePolicy::requestRefresh 图标区域大小变化后调用
+ * 没有在拖拽调整任务栏大小时立即刷新，否则等拖拽结束且大小稳定后再刷新
+ */
+void IconResizePolicy::requestRefresh()
+{
+    if (isResizing()) {
+        m_settleTimer->start();
+        return;
+    }
+
+    m_settleTimer->stop();
+    m_refresh();
+}
+
+/**
+ * @brief IconResizePolicy::cancel 已经按照实际大小刷新过时取消等待中的刷新
+ */
+void IconResizePolicy::cancel()
+{
+    m_settleTimer->stop();
+}
+
+bool IconResizePolicy::isPending() const
+{
+    return m_settleTimer->isActive();
+}
+
+/**
+ * @brief IconResizePolicy::sizeBucket
+ * @param size 图标的实际像素大小
+ * @return 不小于size的渲染档位
+ */
+int IconResizePolicy::sizeBucket(int size)
+{
+    for (int bucket : SizeBuckets) {
+        if (size <= bucket)
+            return bucket;
+    }
+
+    return (size + 63) & ~63;
+}
+
+/**
+ * @brief IconResizePolicy::isResizing
+ * @return 是否正在拖拽调整任务栏大小
+ */
+bool IconResizePolicy::isResizing()
+{
+    return qApp && qApp->property("DRAG_STATE").toBool();
+}
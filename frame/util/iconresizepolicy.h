@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef ICONRESIZEPOLICY_H
+#define ICONRESIZEPOLICY_H
+
+#include <QtGlobal>
+
+#include <functional>
+
+class QObject;
+class QTimer;
+
+/**
+ * @brief The IconResizePolicy class
+ * @note 任务栏大小变化时图标重新渲染的策略，应用图标、托盘图标和插件图标共用：
+ * @note 1、图标先按照档位大小渲染再缩小到实际大小，同一档位内的大小变化不需要重新解析svg
+ * @note 2、拖拽调整任务栏大小时先缩放绘制当前的图标，拖拽结束且大小稳定后再按照实际大小重新渲染
+ */
+class IconResizePolicy
+{
+public:
+    IconResizePolicy(QObject *owner, std::function<void()> refresh);
+    ~IconResizePolicy();
+
+    void requestRefresh();
+    void cancel();
+    bool isPending() const;
+
+    static int sizeBucket(int size);
+    static bool isResizing();
+
+private:
+    Q_DISABLE_COPY(IconResizePolicy)
+
+    QTimer *m_settleTimer;
+    std::function<void()> m_refresh;
+};
+
+#endif // ICONRESIZEPOLICY_H
@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "iconthemepathindex.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+IconThemePathIndex::IconThemePathIndex(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_rebuildTimer(new QTimer(this))
+{
+    // 安装或更新程序时目录会连续变化，合并后再重新建立索引
+    m_rebuildTimer->setSingleShot(true);
+    m_rebuildTimer->setInterval(1000);
+
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &IconThemePathIndex::onDirectoryChanged);
+    connect(m_rebuildTimer, &QTimer::timeout, this, &IconThemePathIndex::rebuildPending);
+}
+
+/**
+ * @brief IconThemePathIndex::lookup 在图标目录中查找图标文件
+ * @param themePath 托盘程序的IconThemePath
+ * @param iconName 图标名，没有完全相同的文件名时按前缀匹配
+ * @param size 需要的像素大小
+ * @return 索引还没有建立完成或者找不到时返回空，索引建立完成后会发送indexChanged信号
+ */
+QString IconThemePathIndex::lookup(const QString &themePath, const QString &iconName, int size)
+{
+    if (themePath.isEmpty() || iconName.isEmpty())
+        return QString();
+
+    if (!m_themePaths.contains(themePath))
+        rebuild(themePath);
+
+    const ThemePath &theme = m_themePaths[themePath];
+    if (!theme.ready)
+        return QString();
+
+    const QString &name = iconName.toLower();
+    auto it = theme.index.constFind(name);
+    if (it != theme.index.constEnd())
+        return bestFile(it.value(), size);
+
+    // 和之前遍历目录时一样，文件名以图标名开头即可，有多个时固定选择按名称排序的第一个
+    auto nameIt = std::lower_bound(theme.names.constBegin(), theme.names.constEnd(), name);
+    if (nameIt != theme.names.constEnd() && nameIt->startsWith(name))
+        return bestFile(theme.index.value(*nameIt), size);
+
+    return QString();
+}
+
+bool IconThemePathIndex::isReady(const QString &themePath) const
+{
+    return m_themePaths.value(themePath).ready;
+}
+
+void IconThemePathIndex::onDirectoryChanged(const QString &path)
+{
+    for (auto it = m_themePaths.constBegin(); it != m_themePaths.constEnd(); ++it) {
+        if (it.value().dirs.contains(path))
+            m_pendingPaths.insert(it.key());
+    }
+
+    m_rebuildTimer->start();
+}
+
+void IconThemePathIndex::rebuildPending()
+{
+    const QSet<QString> paths = m_pendingPaths;
+    m_pendingPaths.clear();
+
+    for (const QString &path : paths)
+        rebuild(path);
+}
+
+/**
+ * @brief IconThemePathIndex::buildIndex 在后台线程中遍历图标目录
+ * @note 只读取图片文件头获取大小，不解码图片
+ */
+IconThemePathIndex::BuildResult IconThemePathIndex::buildIndex(const QString &themePath)
+{
+    BuildResult result;
+    if (!QFileInfo(themePath).isDir())
+        return result;
+
+    result.dirs << QDir(themePath).absolutePath();
+
+    QDirIterator it(themePath, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+
+        const QFileInfo &info = it.fileInfo();
+        if (info.isDir()) {
+            result.dirs << info.absoluteFilePath();
+            continue;
+        }
+
+        IconFile file;
+        file.filePath = info.absoluteFilePath();
+
+        const QString &suffix = info.suffix().toLower();
+        if (suffix == "svg" || suffix == "svgz") {
+            file.size = 0;
+        } else {
+            QImageReader reader(file.filePath);
+            if (!reader.canRead())
+                continue;
+
+            const QSize &size = reader.size();
+            file.size = qMax(size.width(), size.height());
+        }
+
+        result.index[info.completeBaseName().toLower()] << file;
+    }
+
+    result.names = result.index.keys();
+    std::sort(result.names.begin(), result.names.end());
+
+    return result;
+}
+
+/**
+ * @brief IconThemePathIndex::bestFile 选择不小于需要大小的最小图标，其次是矢量图标，都没有时选择最大的图标
+ */
+QString IconThemePathIndex::bestFile(const QList<IconFile> &files, int size)
+{
+    const IconFile *bigger = nullptr;
+    const IconFile *scalable = nullptr;
+    const IconFile *largest = nullptr;
+
+    for (const IconFile &file : files) {
+        if (file.size == 0) {
+            if (!scalable)
+                scalable = &file;
+            continue;
+        }
+
+        if (file.size >= size && (!bigger || file.size < bigger->size))
+            bigger = &file;
+
+        if (!largest || file.size > largest->size)
+            largest = &file;
+    }
+
+    if (bigger)
+        return bigger->filePath;
+
+    if (scalable)
+        return scalable->filePath;
+
+    return largest ? largest->filePath : QString();
+}
+
+void IconThemePathIndex::rebuild(const QString &themePath)
+{
+    ThemePath &theme = m_themePaths[themePath];
+    if (theme.building) {
+        theme.dirty = true;
+        return;
+    }
+
+    theme.building = true;
+    theme.dirty = false;
+
+    QFutureWatcher<BuildResult> *watcher = new QFutureWatcher<BuildResult>(this);
+    connect(watcher, &QFutureWatcher<BuildResult>::finished, this, [ = ] {
+        watcher->deleteLater();
+
+        const BuildResult &result = watcher->result();
+        ThemePath &theme = m_themePaths[themePath];
+
+        if (!theme.dirs.isEmpty())
+            m_watcher->removePaths(theme.dirs);
+        if (!result.dirs.isEmpty())
+            m_watcher->addPaths(result.dirs);
+
+        theme.index = result.index;
+        theme.names = result.names;
+        theme.dirs = result.dirs;
+        theme.ready = true;
+        theme.building = false;
+
+        if (theme.dirty)
+            rebuild(themePath);
+
+        Q_EMIT indexChanged(themePath);
+    });
+
+    watcher->setFuture(QtConcurrent::run(&IconThemePathIndex::buildIndex, themePath));
+}
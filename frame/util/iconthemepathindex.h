@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef ICONTHEMEPATHINDEX_H
+#define ICONTHEMEPATHINDEX_H
+
+#include "singleton.h"
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+/**
+ * @brief The IconThemePathIndex class
+ * @note 托盘程序通过IconThemePath指定私有的图标目录，在后台线程中遍历一次目录，建立图标名到各个尺寸图标文件的索引，
+ * @note 使用相同目录的托盘共用一份索引，目录内容变化时重新建立
+ */
+class IconThemePathIndex : public QObject, public Singleton<IconThemePathIndex>
+{
+    Q_OBJECT
+    friend class Singleton<IconThemePathIndex>;
+
+public:
+    QString lookup(const QString &themePath, const QString &iconName, int size);
+    bool isReady(const QString &themePath) const;
+
+Q_SIGNALS:
+    void indexChanged(const QString &themePath);
+
+private Q_SLOTS:
+    void onDirectoryChanged(const QString &path);
+    void rebuildPending();
+
+private:
+    explicit IconThemePathIndex(QObject *parent = nullptr);
+
+    struct IconFile {
+        QString filePath;
+        int size;               // 为0时表示矢量图标
+    };
+    typedef QHash<QString, QList<IconFile>> Index;      // 小写的图标名 -> 图标文件
+
+    struct BuildResult {
+        Index index;
+        QStringList names;          // 排序后的图标名，用于按前缀查找
+        QStringList dirs;
+    };
+
+    struct ThemePath {
+        Index index;
+        QStringList names;
+        QStringList dirs;
+        bool ready = false;
+        bool building = false;
+        bool dirty = false;         // 建立索引期间目录发生了变化
+    };
+
+    static BuildResult buildIndex(const QString &themePath);
+    static QString bestFile(const QList<IconFile> &files, int size);
+    void rebuild(const QString &themePath);
+
+private:
+    QHash<QString, ThemePath> m_themePaths;
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_rebuildTimer;
+    QSet<QString> m_pendingPaths;
+};
+
+#endif // ICONTHEMEPATHINDEX_H
@@ -9,9 +9,49 @@
 #include <QCursor>
 #include <QGSettings>
 #include <QDebug>
+#include <QtEndian>
 
 #include <X11/Xcursor/Xcursor.h>
 
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+static inline void bswapARGB32Scalar(const uchar *src, uchar *dst, int pixelCount)
+{
+    for (int i = 0; i < pixelCount; ++i) {
+        quint32 pixel;
+        memcpy(&pixel, src + i * 4, 4);
+        pixel = qFromBigEndian(pixel);
+        memcpy(dst + i * 4, &pixel, 4);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// 运行时检测到支持AVX2时才会调用
+__attribute__((target("avx2")))
+static int bswapARGB32AVX2(const uchar *src, uchar *dst, int pixelCount)
+{
+    const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    int i = 0;
+    for (; i + 8 <= pixelCount; i += 8) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), _mm256_shuffle_epi8(v, mask));
+    }
+
+    return i;
+}
+#endif
+
 const QPixmap ImageUtil::loadSvg(const QString &iconName, const QString &localPath, const int size, const qreal ratio)
 {
     QIcon icon = QIcon::fromTheme(iconName);
@@ -64,3 +104,58 @@ QCursor* ImageUtil::loadQCursorFromX11Cursor(const char* theme, const char* curs
     XcursorImagesDestroy(images);
     return cursor;
 }
+
+/**
+ * @brief ImageUtil::convertFromBigEndianARGB32 将大端序的ARGB32像素转换为本机字节序，src和dst可以相同
+ * @note 小端序的机器上按平台使用AVX2/SSE2/NEON批量转换，剩余的像素逐个转换
+ */
+void ImageUtil::convertFromBigEndianARGB32(const uchar *src, uchar *dst, int pixelCount)
+{
+    if (QSysInfo::ByteOrder == QSysInfo::BigEndian) {
+        if (src != dst)
+            memmove(dst, src, size_t(pixelCount) * 4);
+        return;
+    }
+
+    int i = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+    if (hasAVX2)
+        i = bswapARGB32AVX2(src, dst, pixelCount);
+#endif
+
+#if defined(__SSE2__)
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+        // 先交换32位中的两个16位，再交换16位中的两个字节
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), v);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 4 <= pixelCount; i += 4)
+        vst1q_u8(dst + i * 4, vrev32q_u8(vld1q_u8(src + i * 4)));
+#endif
+
+    bswapARGB32Scalar(src + i * 4, dst + i * 4, pixelCount - i);
+}
+
+/**
+ * @brief ImageUtil::fromBigEndianARGB32 从大端序的ARGB32数据(如StatusNotifierItem的IconPixmap)创建图片
+ * @note 直接转换到图片的内存中，不需要先复制原始数据
+ */
+QImage ImageUtil::fromBigEndianARGB32(const uchar *data, int width, int height)
+{
+    if (!data || width <= 0 || height <= 0)
+        return QImage();
+
+    QImage image(width, height, QImage::Format_ARGB32);
+    if (image.isNull())
+        return image;
+
+    // 图片每行按4字节对齐，ARGB32的行之间没有空隙
+    convertFromBigEndianARGB32(data, image.bits(), width * height);
+
+    return image;
+}
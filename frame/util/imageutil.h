@@ -18,6 +18,8 @@ public:
     static const QPixmap loadSvg(const QString &iconName, const QString &localPath, const int size, const qreal ratio);
     static const QPixmap loadSvg(const QString &iconName, const QSize size, const qreal ratio = qApp->devicePixelRatio());
     static QCursor* loadQCursorFromX11Cursor(const char* theme, const char* cursorName, int cursorSize);
+    static void convertFromBigEndianARGB32(const uchar *src, uchar *dst, int pixelCount);
+    static QImage fromBigEndianARGB32(const uchar *data, int width, int height);
 };
 
 #endif // IMAGEUTIL_H
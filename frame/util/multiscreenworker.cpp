@@ -3,11 +3,14 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
 #include "multiscreenworker.h"
+#include "cursoredgemonitor.h"
 #include "mainwindow.h"
 #include "utils.h"
 #include "displaymanager.h"
+#include "startuptracer.h"
 
 #include <DWindowManagerHelper>
+#include <DConfig>
 
 #include <QWidget>
 #include <QScreen>
@@ -28,6 +31,21 @@ const QString OnlyShowPrimary = "onlyShowPrimary";
 #define WINDOW_MARGIN ((m_displayMode == Dock::Efficient) ? 0 : 10)
 #define DIS_INS DisplayManager::instance()
 
+/**
+ * @brief cursorEdgeMonitorEnabled
+ * @return 是否在进程内监听鼠标移动，关闭后仍然使用XEventMonitor，重启任务栏后生效
+ */
+static bool cursorEdgeMonitorEnabled()
+{
+    bool enabled = true;
+    DConfig *config = DConfig::create("org.deepin.dde.dock", "org.deepin.dde.dock");
+    if (config->isValid() && config->keyList().contains("cursorEdgeMonitor"))
+        enabled = config->value("cursorEdgeMonitor").toBool();
+    delete config;
+
+    return enabled;
+}
+
 // 保证以下数据更新顺序(大环节顺序不要变，内部还有一些小的调整，比如任务栏显示区域更新的时候，里面内容的布局方向可能也要更新...)
 // Monitor数据－＞屏幕是否可停靠更新－＞监视唤醒区域更新，任务栏显示区域更新－＞拖拽区域更新－＞通知后端接口，通知窗管
 
@@ -37,6 +55,7 @@ MultiScreenWorker::MultiScreenWorker(QWidget *parent)
     , m_eventInter(new XEventMonitor("com.deepin.api.XEventMonitor", "/com/deepin/api/XEventMonitor", QDBusConnection::sessionBus(), this))
     , m_extralEventInter(new XEventMonitor("com.deepin.api.XEventMonitor", "/com/deepin/api/XEventMonitor", QDBusConnection::sessionBus(), this))
     , m_touchEventInter(new XEventMonitor("com.deepin.api.XEventMonitor", "/com/deepin/api/XEventMonitor", QDBusConnection::sessionBus(), this))
+    , m_edgeMonitor(new CursorEdgeMonitor(this))
     , m_dockInter(new DBusDock("com.deepin.dde.daemon.Dock", "/com/deepin/dde/daemon/Dock", QDBusConnection::sessionBus(), this))
     , m_launcherInter(new DBusLuncher("com.deepin.dde.Launcher", "/com/deepin/dde/Launcher", QDBusConnection::sessionBus(), this))
     , m_monitorUpdateTimer(new QTimer(this))
@@ -47,9 +66,14 @@ MultiScreenWorker::MultiScreenWorker(QWidget *parent)
 {
     qInfo() << "init dock screen: " << m_ds.current();
 
+    TraceSpan span("MultiScreenWorker");
+
     initConnection();
     initMembers();
-    initDBus();
+    {
+        TraceSpan dbusSpan("MultiScreenWorker::initDBus");
+        initDBus();
+    }
     initDisplayData();
     initUI();
 }
@@ -282,6 +306,9 @@ void MultiScreenWorker::onWindowSizeChanged(uint value)
     Q_UNUSED(value);
 
     m_monitorUpdateTimer->start();
+
+    // 任务栏区域随大小变化
+    emit requestUpdateRegionMonitor();
 }
 
 void MultiScreenWorker::primaryScreenChanged(QScreen *screen)
@@ -363,6 +390,9 @@ void MultiScreenWorker::onPositionChanged(const Position &position)
         // 一直显示的模式才需要显示
         emit requestUpdatePosition(lastPos, position);
     }
+
+    // 唤醒区域和任务栏区域在屏幕的另一条边上
+    emit requestUpdateRegionMonitor();
 }
 
 void MultiScreenWorker::onDisplayModeChanged(const DisplayMode &displayMode)
@@ -394,6 +424,8 @@ void MultiScreenWorker::onDisplayModeChanged(const DisplayMode &displayMode)
     emit displayModeChanegd();
     emit requestUpdateFrontendGeometry();
     emit requestNotifyWindowManager();
+    // 时尚模式和高效模式的任务栏区域大小不同
+    emit requestUpdateRegionMonitor();
 }
 
 void MultiScreenWorker::onHideModeChanged(const HideMode &hideMode)
@@ -494,159 +526,84 @@ void MultiScreenWorker::onRequestUpdateRegionMonitor()
     // 后端认为的任务栏大小(无缩放因素影响)
     const int realDockSize = int((m_displayMode == DisplayMode::Fashion ? m_dockInter->windowSizeFashion() + 2 * 10 /*上下的边距各10像素*/ : m_dockInter->windowSizeEfficient()) * qApp->devicePixelRatio());
 
-    // 任务栏唤起区域
-    m_monitorRectList.clear();
-    for (auto s : DIS_INS->screens()) {
-        // 屏幕此位置不可停靠时,不用监听这块区域
-        if (!DIS_INS->canDock(s, m_position))
-            continue;
+    // 触屏监控高度固定调整为最大任务栏高度100+任务栏与屏幕边缘间距
+    const int monitHeight = 100 + WINDOW_MARGIN;
 
+    // 屏幕m_position位置边缘上宽度为size的区域
+    auto edgeRect = [ this ](const QRect &screenRect, int size) {
         MonitRect monitorRect;
-        QRect screenRect = s->geometry();
-        screenRect.setSize(screenRect.size() * s->devicePixelRatio());
+        monitorRect.x1 = screenRect.x();
+        monitorRect.y1 = screenRect.y();
+        monitorRect.x2 = screenRect.x() + screenRect.width();
+        monitorRect.y2 = screenRect.y() + screenRect.height();
 
         switch (m_position) {
-        case Top: {
-            monitorRect.x1 = screenRect.x();
-            monitorRect.y1 = screenRect.y();
-            monitorRect.x2 = screenRect.x() + screenRect.width();
-            monitorRect.y2 = screenRect.y() + monitorHeight;
-        }
+        case Top:
+            monitorRect.y2 = screenRect.y() + size;
             break;
-        case Bottom: {
-            monitorRect.x1 = screenRect.x();
-            monitorRect.y1 = screenRect.y() + screenRect.height() - monitorHeight;
-            monitorRect.x2 = screenRect.x() + screenRect.width();
-            monitorRect.y2 = screenRect.y() + screenRect.height();
-        }
+        case Bottom:
+            monitorRect.y1 = screenRect.y() + screenRect.height() - size;
             break;
-        case Left: {
-            monitorRect.x1 = screenRect.x();
-            monitorRect.y1 = screenRect.y();
-            monitorRect.x2 = screenRect.x() + monitorHeight;
-            monitorRect.y2 = screenRect.y() + screenRect.height();
-        }
+        case Left:
+            monitorRect.x2 = screenRect.x() + size;
             break;
-        case Right: {
-            monitorRect.x1 = screenRect.x() + screenRect.width() - monitorHeight;
-            monitorRect.y1 = screenRect.y();
-            monitorRect.x2 = screenRect.x() + screenRect.width();
-            monitorRect.y2 = screenRect.y() + screenRect.height();
-        }
+        case Right:
+            monitorRect.x1 = screenRect.x() + screenRect.width() - size;
             break;
         }
 
-        if (!m_monitorRectList.contains(monitorRect)) {
-            m_monitorRectList << monitorRect;
-#ifdef QT_DEBUG
-            qDebug() << "监听区域：" << monitorRect.x1 << monitorRect.y1 << monitorRect.x2 << monitorRect.y2;
-#endif
-        }
-    }
+        return monitorRect;
+    };
 
-    m_extralRectList.clear();
-    for (auto s : DIS_INS->screens()) {
+    m_monitorRectList.clear();          // 任务栏唤起区域
+    m_extralRectList.clear();           // 任务栏内部区域
+    m_touchRectList.clear();            // 任务栏触屏唤起区域
+
+    // 屏幕区域和可停靠位置已经在快照中计算好，不需要再遍历QScreen
+    const ScreenTopologyPtr topology = DIS_INS->topology();
+    for (int i = 0; i < topology->count(); ++i) {
         // 屏幕此位置不可停靠时,不用监听这块区域
-        if (!DIS_INS->canDock(s, m_position))
+        if (!topology->canDock(i, m_position))
             continue;
 
-        MonitRect monitorRect;
-        QRect screenRect = s->geometry();
-        screenRect.setSize(screenRect.size() * s->devicePixelRatio());
+        const QRect &screenRect = topology->rect(i);
 
-        switch (m_position) {
-        case Top: {
-            monitorRect.x1 = screenRect.x();
-            monitorRect.y1 = screenRect.y();
-            monitorRect.x2 = screenRect.x() + screenRect.width();
-            monitorRect.y2 = screenRect.y() + realDockSize;
-        }
-            break;
-        case Bottom: {
-            monitorRect.x1 = screenRect.x();
-            monitorRect.y1 = screenRect.y() + screenRect.height() - realDockSize;
-            monitorRect.x2 = screenRect.x() + screenRect.width();
-            monitorRect.y2 = screenRect.y() + screenRect.height();
-        }
-            break;
-        case Left: {
-            monitorRect.x1 = screenRect.x();
-            monitorRect.y1 = screenRect.y();
-            monitorRect.x2 = screenRect.x() + realDockSize;
-            monitorRect.y2 = screenRect.y() + screenRect.height();
-        }
-            break;
-        case Right: {
-            monitorRect.x1 = screenRect.x() + screenRect.width() - realDockSize;
-            monitorRect.y1 = screenRect.y();
-            monitorRect.x2 = screenRect.x() + screenRect.width();
-            monitorRect.y2 = screenRect.y() + screenRect.height();
-        }
-            break;
-        }
-
-        if (!m_extralRectList.contains(monitorRect)) {
-            m_extralRectList << monitorRect;
+        const MonitRect monitorRect = edgeRect(screenRect, monitorHeight);
+        if (!m_monitorRectList.contains(monitorRect)) {
+            m_monitorRectList << monitorRect;
 #ifdef QT_DEBUG
-            qDebug() << "任务栏内部区域：" << monitorRect.x1 << monitorRect.y1 << monitorRect.x2 << monitorRect.y2;
+            qDebug() << "监听区域：" << monitorRect.x1 << monitorRect.y1 << monitorRect.x2 << monitorRect.y2;
 #endif
         }
-    }
-
-    // 触屏监控高度固定调整为最大任务栏高度100+任务栏与屏幕边缘间距
-    const int monitHeight = 100 + WINDOW_MARGIN;
-
-    // 任务栏触屏唤起区域
-    m_touchRectList.clear();
-    for (auto s : DIS_INS->screens()) {
-        // 屏幕此位置不可停靠时,不用监听这块区域
-        if (!DIS_INS->canDock(s, m_position))
-            continue;
-
-        MonitRect monitorRect;
-        QRect screenRect = s->geometry();
-        screenRect.setSize(screenRect.size() * s->devicePixelRatio());
-
-        switch (m_position) {
-        case Top: {
-            monitorRect.x1 = screenRect.x();
-            monitorRect.y1 = screenRect.y();
-            monitorRect.x2 = screenRect.x() + screenRect.width();
-            monitorRect.y2 = screenRect.y() + monitHeight;
-        }
-            break;
-        case Bottom: {
-            monitorRect.x1 = screenRect.x();
-            monitorRect.y1 = screenRect.y() + screenRect.height() - monitHeight;
-            monitorRect.x2 = screenRect.x() + screenRect.width();
-            monitorRect.y2 = screenRect.y() + screenRect.height();
-        }
-            break;
-        case Left: {
-            monitorRect.x1 = screenRect.x();
-            monitorRect.y1 = screenRect.y();
-            monitorRect.x2 = screenRect.x() + monitHeight;
-            monitorRect.y2 = screenRect.y() + screenRect.height();
-        }
-            break;
-        case Right: {
-            monitorRect.x1 = screenRect.x() + screenRect.width() - monitHeight;
-            monitorRect.y1 = screenRect.y();
-            monitorRect.x2 = screenRect.x() + screenRect.width();
-            monitorRect.y2 = screenRect.y() + screenRect.height();
-        }
-            break;
-        }
-
 
-        if (!m_touchRectList.contains(monitorRect)) {
-            m_touchRectList << monitorRect;
+        const MonitRect extralRect = edgeRect(screenRect, realDockSize);
+        if (!m_extralRectList.contains(extralRect)) {
+            m_extralRectList << extralRect;
+#ifdef QT_DEBUG
+            qDebug() << "任务栏内部区域：" << extralRect.x1 << extralRect.y1 << extralRect.x2 << extralRect.y2;
+#endif
         }
 
+        const MonitRect touchRect = edgeRect(screenRect, monitHeight);
+        if (!m_touchRectList.contains(touchRect))
+            m_touchRectList << touchRect;
     }
 
-    m_registerKey = m_eventInter->RegisterAreas(m_monitorRectList, flags);
-    m_extralRegisterKey = m_extralEventInter->RegisterAreas(m_extralRectList, flags);
+    if (m_edgeMonitor->isRunning()) {
+        auto toRects = [ ](const QList<MonitRect> &monitorRects) {
+            QList<QRect> rects;
+            for (const MonitRect &r : monitorRects)
+                rects << QRect(QPoint(r.x1, r.y1), QPoint(r.x2, r.y2));
+            return rects;
+        };
+        m_edgeMonitor->setAreas(toRects(m_monitorRectList), toRects(m_extralRectList));
+
+        // 鼠标移动由m_edgeMonitor处理，这里只需要按键事件
+        m_registerKey = m_eventInter->RegisterAreas(m_monitorRectList, Button | Key);
+    } else {
+        m_registerKey = m_eventInter->RegisterAreas(m_monitorRectList, flags);
+        m_extralRegisterKey = m_extralEventInter->RegisterAreas(m_extralRectList, flags);
+    }
     m_touchRegisterKey = m_touchEventInter->RegisterAreas(m_touchRectList, flags);
 }
 
@@ -938,6 +895,18 @@ void MultiScreenWorker::initMembers()
 
     m_delayWakeTimer->setSingleShot(true);
 
+    // 鼠标移动不再经过D-Bus，只有进出唤醒区域和任务栏区域时才会通知，不支持时仍使用XEventMonitor
+    if (cursorEdgeMonitorEnabled() && m_edgeMonitor->start()) {
+        connect(m_edgeMonitor, &CursorEdgeMonitor::wakeAreaEntered, this, [ = ](int x, int y) {
+            if (!testState(MousePress))
+                tryToShowDock(x, y);
+        });
+        connect(m_edgeMonitor, &CursorEdgeMonitor::dockAreaLeft, this, [ = ](int x, int y) {
+            onCursorOut(x, y, m_extralRegisterKey);
+        });
+        connect(qApp, &QCoreApplication::aboutToQuit, m_edgeMonitor, &CursorEdgeMonitor::stop);
+    }
+
     setStates(LauncherDisplay, m_launcherInter->isValid() ? m_launcherInter->visible() : false);
 
     // init check
@@ -978,6 +947,7 @@ void MultiScreenWorker::initConnection()
     connect(this, &MultiScreenWorker::requestUpdatePosition, this, &MultiScreenWorker::onRequestUpdatePosition);
     connect(this, &MultiScreenWorker::requestNotifyWindowManager, this, &MultiScreenWorker::onRequestNotifyWindowManager);
     connect(this, &MultiScreenWorker::requestUpdateMonitorInfo, this, &MultiScreenWorker::onRequestUpdateMonitorInfo);
+    connect(this, &MultiScreenWorker::requestUpdateRegionMonitor, this, &MultiScreenWorker::onRequestUpdateRegionMonitor);
 
     connect(m_delayWakeTimer, &QTimer::timeout, this, &MultiScreenWorker::onRequestDelayShowDock);
 
@@ -1389,49 +1359,37 @@ void MultiScreenWorker::checkDaemonDockService()
 
 bool MultiScreenWorker::isCursorOut(int x, int y)
 {
-    const int realDockSize = int((m_displayMode == DisplayMode::Fashion ? m_dockInter->windowSizeFashion() + 2 * 10 /*上下的边距各10像素*/ : m_dockInter->windowSizeEfficient()) * qApp->devicePixelRatio());
-    for (auto s : DIS_INS->screens()) {
-        // 屏幕此位置不可停靠时,不用监听这块区域
-        if (!DIS_INS->canDock(s, m_position))
-            continue;
-
-        QRect screenRect = s->geometry();
-        screenRect.setSize(screenRect.size() * s->devicePixelRatio());
-
-        if (m_position == Top) {
-            // 如果任务栏在顶部
-            if (x < screenRect.x() || x > (screenRect.x() + screenRect.width()))
+    // 任务栏区域在更新监听区域时已经计算好，不再每次获取任务栏大小和遍历屏幕
+    for (const MonitRect &rect : m_extralRectList) {
+        if (m_position == Top || m_position == Bottom) {
+            if (x < rect.x1 || x > rect.x2)
                 continue;
 
-            return (y > (screenRect.y() + realDockSize) || y < screenRect.y());
+            return (y < rect.y1 || y > rect.y2);
         }
 
-        if (m_position == Bottom) {
-            // 如果任务栏在底部
-            if (x < screenRect.x() || x > (screenRect.x() + screenRect.width()))
-                continue;
-
-            return (y < (screenRect.y() + screenRect.height() - realDockSize) || y > (screenRect.y() + screenRect.height()));
-        }
+        if (y < rect.y1 || y > rect.y2)
+            continue;
 
-        if (m_position == Left) {
-            // 如果任务栏在左侧
-            if (y < screenRect.y() || y > (screenRect.y() + screenRect.height()))
-                continue;
+        return (x < rect.x1 || x > rect.x2);
+    }
 
-            return (x > (screenRect.x() + realDockSize) || x < screenRect.x());
-        }
+    return false;
+}
 
-        if (m_position == Right) {
-            // 如果在任务栏右侧
-            if (y < screenRect.y() || y > (screenRect.y() + screenRect.height()))
-                continue;
+void MultiScreenWorker::onCursorOut(int x, int y, const QString &key)
+{
+    if (!isCursorOut(x, y))
+        return;
 
-            return (x < (screenRect.x() + screenRect.width() - realDockSize) || x > (screenRect.x() + screenRect.width()));
-        }
+    if (testState(ShowAnimationStart)) {
+        // 在OUT后如果检测到当前的动画正在进行，在out后延迟500毫秒等动画结束再执行移出动画
+        QTimer::singleShot(500, this, [ = ] {
+            onExtralRegionMonitorChanged(x, y, key);
+        });
+    } else {
+        onExtralRegionMonitorChanged(x, y, key);
     }
-
-    return false;
 }
 
 /**
@@ -1459,18 +1417,7 @@ void MultiScreenWorker::checkXEventMonitorService()
             });
         });
 
-        connect(extralEventInter, &XEventMonitor::CursorOut, this, [ = ](int x, int y, const QString &key) {
-            if (isCursorOut(x, y)) {
-                if (testState(ShowAnimationStart)) {
-                    // 在OUT后如果检测到当前的动画正在进行，在out后延迟500毫秒等动画结束再执行移出动画
-                    QTimer::singleShot(500, this, [ = ] {
-                        onExtralRegionMonitorChanged(x, y, key);
-                    });
-                } else {
-                    onExtralRegionMonitorChanged(x, y, key);
-                }
-            }
-        });
+        connect(extralEventInter, &XEventMonitor::CursorOut, this, &MultiScreenWorker::onCursorOut);
 
         // 触屏时，后端只发送press、release消息，有move消息则为鼠标，press置false
         connect(touchEventInter, &XEventMonitor::CursorMove, this, [ = ] {
@@ -1673,10 +1620,10 @@ QScreen *MultiScreenWorker::screenByName(const QString &screenName)
 
 bool MultiScreenWorker::onScreenEdge(const QString &screenName, const QPoint &point)
 {
-    QScreen *screen = screenByName(screenName);
-    if (screen) {
-        const QRect r { screen->geometry() };
-        const QRect rect { r.topLeft(), r.size() *screen->devicePixelRatio() };
+    const ScreenTopologyPtr topology = DIS_INS->topology();
+    const int index = topology->indexOf(DIS_INS->screen(screenName));
+    if (index >= 0) {
+        const QRect &rect = topology->rect(index);
 
         // 除了要判断鼠标的x坐标和当前区域的位置外，还需要判断当前的坐标的y坐标是否在任务栏的区域内
         // 因为有如下场景：任务栏在左侧，双屏幕屏幕上下拼接，此时鼠标沿着最左侧x=0的位置移动到另外一个屏幕
@@ -1698,7 +1645,7 @@ bool MultiScreenWorker::onScreenEdge(const QString &screenName, const QPoint &po
 
 const QPoint MultiScreenWorker::rawXPosition(const QPoint &scaledPos)
 {
-    QScreen const *screen = Utils::screenAtByScaled(scaledPos);
+    QScreen const *screen = DIS_INS->topology()->screenAt(scaledPos);
 
     return screen ? screen->geometry().topLeft() +
                     (scaledPos - screen->geometry().topLeft()) *
@@ -1795,7 +1742,7 @@ void MultiScreenWorker::tryToShowDock(int eventX, int eventY)
     }
 
     QString toScreen;
-    QScreen *screen = Utils::screenAtByScaled(QPoint(eventX, eventY));
+    QScreen *screen = DIS_INS->topology()->screenAt(QPoint(eventX, eventY));
     if (!screen) {
         qWarning() << "cannot find the screen" << QPoint(eventX, eventY);
         return;
@@ -1805,7 +1752,7 @@ void MultiScreenWorker::tryToShowDock(int eventX, int eventY)
 
     /**
      * 坐标位于当前屏幕边缘时,当做屏幕内移动处理(防止鼠标移动到边缘时不唤醒任务栏)
-     * 使用screenAtByScaled获取屏幕名时,实际上获取的不一定是当前屏幕
+     * 根据坐标获取屏幕名时,实际上获取的不一定是当前屏幕
      * 举例:点(100,100)不在(0,0,100,100)的屏幕上
      */
     if (onScreenEdge(m_ds.current(), QPoint(eventX, eventY))) {
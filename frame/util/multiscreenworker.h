@@ -41,6 +41,7 @@ class QTimer;
 class MainWindow;
 class QGSettings;
 class ScreenChangeMonitor;
+class CursorEdgeMonitor;
 
 /**
  * @brief The DockScreen class
@@ -226,6 +227,7 @@ private:
     QRect getDockShowGeometry(const QString &screenName, const Position &pos, const DisplayMode &displaymode, bool withoutScale = false);
     QRect getDockHideGeometry(const QString &screenName, const Position &pos, const DisplayMode &displaymode, bool withoutScale = false);
     bool isCursorOut(int x, int y);
+    void onCursorOut(int x, int y, const QString &key);
 
     QScreen *screenByName(const QString &screenName);
     bool onScreenEdge(const QString &screenName, const QPoint &point);
@@ -240,6 +242,7 @@ private:
     XEventMonitor *m_eventInter;
     XEventMonitor *m_extralEventInter;
     XEventMonitor *m_touchEventInter;
+    CursorEdgeMonitor *m_edgeMonitor;           // 支持XInput2时在进程内判断鼠标是否进入唤醒区域
 
     // DBus interface
     DBusDock *m_dockInter;
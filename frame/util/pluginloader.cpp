@@ -3,28 +3,39 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
 #include "pluginloader.h"
+#include "pluginmanifest.h"
+#include "startuptracer.h"
 #include "utils.h"
 
 #include <QDir>
 #include <QDebug>
 #include <QLibrary>
 #include <QGSettings>
-#include <QProcess>
 #include <QtConcurrent>
 #include <QFuture>
+#include <QLibraryInfo>
+#include <QMutex>
 
 #include <DSysInfo>
 
+#include <elf.h>
+#include <sys/stat.h>
+#include <cstring>
+
 DCORE_USE_NAMESPACE
 
 PluginLoader::PluginLoader(const QString &pluginDirPath, QObject *parent)
     : QThread(parent)
     , m_pluginDirPath(pluginDirPath)
 {
+    // 在主线程中创建
+    PluginManifest::instance();
 }
 
 void PluginLoader::run()
 {
+    TraceSpan span("PluginLoader::run", m_pluginDirPath);
+
     QDir pluginsDir(m_pluginDirPath);
     const QStringList files = pluginsDir.entryList(QDir::Files);
 
@@ -68,8 +79,8 @@ void PluginLoader::run()
         filePaths.push_back(pluginsDir.absoluteFilePath(file));
     }
 
-    // 由于使用ldd获取.so信息比较耗时，采用并行处理
-    QFuture<QString> f = QtConcurrent::mapped(filePaths, &PluginLoader::libUsedDtkCoreFileName);
+    // 读取插件的元数据和依赖的dtkcore库，插件文件没有变化时直接使用缓存，采用并行处理
+    QFuture<QString> f = QtConcurrent::mapped(filePaths, &PluginManifest::probe);
     f.waitForFinished();
     const QStringList &results = f.results();
     if (results.size() == filePaths.size()) {
@@ -92,8 +103,8 @@ void PluginLoader::run()
 }
 
 /**
- * @brief 获取当前进程使用的dtkcore库的文件名
- * @return 当前进程使用的dtkCore库的文件名
+ * @brief 获取当前进程使用的dtkcore库的SONAME
+ * @return 当前进程使用的dtkCore库的SONAME，读取失败时返回文件名
  */
 QString PluginLoader::dtkCoreFileName()
 {
@@ -102,67 +113,59 @@ QString PluginLoader::dtkCoreFileName()
         return QString();
 
     const QByteArray &data = f.readAll();
-    QTextStream ts(data);
-    while (Q_UNLIKELY(!ts.atEnd())) {
-        const QString line = ts.readLine();
-        const QStringList &maps = line.split(' ', QString::SplitBehavior::SkipEmptyParts);
-        if (Q_UNLIKELY(maps.size() < 6))
-            continue;
+    f.close();
 
-        QFileInfo info(maps.value(5));
-        QString infoAbPath = info.absoluteFilePath();
-        if (info.fileName().contains("dtkcore")) {
-            infoAbPath = realFileName(infoAbPath);
-            if (infoAbPath.contains("/")) {
-                int pathIndex = infoAbPath.lastIndexOf("/");
-                infoAbPath = infoAbPath.mid(pathIndex + 1).trimmed();
-            }
-
-            f.close();
-            return infoAbPath;
-        }
-    }
+    // 只对包含dtkcore的行做拆分，不需要逐行构造QString
+    const int index = data.indexOf("dtkcore");
+    if (index < 0)
+        return QString();
 
-    f.close();
-    return QString();
+    const int lineStart = data.lastIndexOf('\n', index) + 1;
+    const int pathStart = data.indexOf('/', lineStart);
+    int lineEnd = data.indexOf('\n', index);
+    if (lineEnd < 0)
+        lineEnd = data.size();
+
+    if (pathStart < 0 || pathStart > index)
+        return QString();
+
+    const QString &filePath = QString::fromLocal8Bit(data.mid(pathStart, lineEnd - pathStart)).trimmed();
+
+    ElfDynamicInfo info;
+    if (readElfDynamicInfo(filePath, info) && !info.soname.isEmpty())
+        return info.soname;
+
+    return QFileInfo(realFileName(filePath)).fileName();
 }
 
 /**
- * @brief 返回某个so库使用的dtkcore库文件名
+ * @brief 返回某个so库使用的dtkcore库的SONAME
  * @param 用于获取dtkcore库的so库文件名
- * @return 返回使用的dtkcore库文件名
+ * @return 返回使用的dtkcore库的SONAME
+ * @note 直接读取ELF文件中的DT_NEEDED，不再调用ldd，结果按照(路径, inode, 修改时间)缓存
  */
 QString PluginLoader::libUsedDtkCoreFileName(const QString &fileName)
 {
-    QString lddCommand = QString("ldd -r %1").arg(fileName);
-    FILE *fp = popen(lddCommand.toLocal8Bit().data(), "r");
-    if (fp) {
-        char buf[2000] = {0};
-        while (fgets(buf, sizeof(buf), fp)) {
-            QString rowResult = buf;
-            rowResult = rowResult.trimmed();
-            if (rowResult.contains("dtkcore")) {
-                QStringList coreSplits = rowResult.split("=>");
-                if (coreSplits.size() < 2)
-                    continue;
-
-                pclose(fp);
-                QString dtkCorePath = coreSplits[1];
-
-                // 删除后面的括号的内容
-                int addrIndex = dtkCorePath.indexOf("(0x");
-                dtkCorePath = realFileName(dtkCorePath.left(addrIndex).trimmed());
-                if (dtkCorePath.contains("/")) {
-                    int pathIndex = dtkCorePath.lastIndexOf("/");
-                    dtkCorePath = dtkCorePath.mid(pathIndex + 1).trimmed();
-                }
-
-                return dtkCorePath;
-            }
-        }
-        pclose(fp);
+    static QMutex mutex;
+    static QHash<QString, DtkCoreCacheInfo> cache;
+
+    struct stat st;
+    if (stat(fileName.toLocal8Bit().constData(), &st) != 0)
+        return QString();
+
+    {
+        QMutexLocker locker(&mutex);
+        auto it = cache.constFind(fileName);
+        if (it != cache.constEnd() && it->inode == st.st_ino && it->mtime == st.st_mtime)
+            return it->dtkCore;
     }
-    return QString();
+
+    const QString &dtkCore = findDtkCore(fileName, 0);
+
+    QMutexLocker locker(&mutex);
+    cache.insert(fileName, DtkCoreCacheInfo { st.st_ino, st.st_mtime, dtkCore });
+
+    return dtkCore;
 }
 
 /**
@@ -172,21 +175,162 @@ QString PluginLoader::libUsedDtkCoreFileName(const QString &fileName)
  */
 QString PluginLoader::realFileName(QString fileName)
 {
-    QString command = QString("ls %1 -al").arg(fileName);
-    FILE *fp = popen(command.toLocal8Bit().data(), "r");
-    if (fp) {
-        char buf[2000] = {0};
-        if (fgets(buf, sizeof(buf), fp)) {
-            QString rowInfo = buf;
-            if (rowInfo.contains("->")) {
-                pclose(fp);
-                QStringList fileInfos = rowInfo.split("->");
-                QString srcFileName = fileInfos[1];
-                srcFileName = srcFileName.trimmed();
-                return srcFileName;
-            }
+    const QString &canonicalFilePath = QFileInfo(fileName).canonicalFilePath();
+    return canonicalFilePath.isEmpty() ? fileName : canonicalFilePath;
+}
+
+/**
+ * @brief 在so库及其依赖的dtk库中查找依赖的dtkcore库
+ * @param fileName so库文件名
+ * @param depth 当前查找的依赖层级，插件可能只直接依赖dtkwidget或dtkgui
+ * @return dtkcore库的SONAME
+ */
+QString PluginLoader::findDtkCore(const QString &fileName, int depth)
+{
+    ElfDynamicInfo info;
+    if (!readElfDynamicInfo(fileName, info))
+        return QString();
+
+    for (const QString &needed : info.needed) {
+        if (needed.contains("dtkcore"))
+            return needed;
+    }
+
+    if (depth >= 2)
+        return QString();
+
+    // 没有直接依赖dtkcore时，在依赖的其他dtk库中继续查找
+    QStringList searchPaths = info.runpaths;
+    searchPaths << QString::fromLocal8Bit(qgetenv("LD_LIBRARY_PATH")).split(':', QString::SkipEmptyParts);
+    searchPaths << QLibraryInfo::location(QLibraryInfo::LibrariesPath) << "/usr/lib" << "/lib";
+
+    for (const QString &needed : info.needed) {
+        if (!needed.startsWith("libdtk"))
+            continue;
+
+        for (QString path : searchPaths) {
+            path.replace("$ORIGIN", QFileInfo(fileName).absolutePath());
+            const QString &libPath = path + "/" + needed;
+            if (!QFileInfo::exists(libPath))
+                continue;
+
+            const QString &dtkCore = findDtkCore(libPath, depth + 1);
+            if (!dtkCore.isEmpty())
+                return dtkCore;
+
+            break;
+        }
+    }
+
+    return QString();
+}
+
+template <typename Ehdr, typename Phdr, typename Dyn>
+static bool readDynamicSection(const uchar *data, qint64 size, PluginLoader::ElfDynamicInfo &info)
+{
+    if (size < qint64(sizeof(Ehdr)))
+        return false;
+
+    const Ehdr *ehdr = reinterpret_cast<const Ehdr *>(data);
+    if (ehdr->e_phoff == 0 || ehdr->e_phentsize != sizeof(Phdr)
+            || qint64(ehdr->e_phoff + quint64(ehdr->e_phnum) * sizeof(Phdr)) > size)
+        return false;
+
+    const Phdr *phdrs = reinterpret_cast<const Phdr *>(data + ehdr->e_phoff);
+    const Phdr *dynamic = nullptr;
+    for (int i = 0; i < ehdr->e_phnum; ++i) {
+        if (phdrs[i].p_type == PT_DYNAMIC) {
+            dynamic = &phdrs[i];
+            break;
         }
-        pclose(fp);
     }
-    return fileName;
+
+    if (!dynamic || qint64(dynamic->p_offset + dynamic->p_filesz) > size)
+        return false;
+
+    // DT_STRTAB中保存的是虚拟地址，需要通过PT_LOAD段转换为文件偏移
+    auto fileOffset = [ = ](quint64 address) -> qint64 {
+        for (int i = 0; i < ehdr->e_phnum; ++i) {
+            const Phdr &phdr = phdrs[i];
+            if (phdr.p_type == PT_LOAD && address >= phdr.p_vaddr && address < phdr.p_vaddr + phdr.p_filesz)
+                return qint64(phdr.p_offset + (address - phdr.p_vaddr));
+        }
+        return -1;
+    };
+
+    const Dyn *dyn = reinterpret_cast<const Dyn *>(data + dynamic->p_offset);
+    const quint64 count = dynamic->p_filesz / sizeof(Dyn);
+
+    quint64 strtab = 0;
+    quint64 strsz = 0;
+    qint64 soname = -1;
+    QVector<quint64> needed;
+    QVector<quint64> runpaths;
+    for (quint64 i = 0; i < count && dyn[i].d_tag != DT_NULL; ++i) {
+        switch (dyn[i].d_tag) {
+        case DT_STRTAB: strtab = dyn[i].d_un.d_ptr;             break;
+        case DT_STRSZ:  strsz = dyn[i].d_un.d_val;              break;
+        case DT_NEEDED: needed << dyn[i].d_un.d_val;            break;
+        case DT_SONAME: soname = qint64(dyn[i].d_un.d_val);     break;
+        case DT_RPATH:
+        case DT_RUNPATH: runpaths << dyn[i].d_un.d_val;         break;
+        default: break;
+        }
+    }
+
+    const qint64 strOffset = fileOffset(strtab);
+    if (strOffset < 0 || qint64(strOffset + strsz) > size)
+        return false;
+
+    const char *strings = reinterpret_cast<const char *>(data + strOffset);
+    auto stringAt = [ = ](quint64 offset) {
+        if (offset >= strsz)
+            return QString();
+        return QString::fromLocal8Bit(strings + offset, int(strnlen(strings + offset, strsz - offset)));
+    };
+
+    for (quint64 offset : needed)
+        info.needed << stringAt(offset);
+    for (quint64 offset : runpaths)
+        info.runpaths << stringAt(offset).split(':', QString::SkipEmptyParts);
+    if (soname >= 0)
+        info.soname = stringAt(quint64(soname));
+
+    return true;
+}
+
+/**
+ * @brief 通过mmap读取ELF文件的动态段
+ * @param fileName so库文件名
+ * @param info 保存DT_NEEDED、DT_SONAME和DT_RUNPATH/DT_RPATH
+ * @return 是否读取成功
+ */
+bool PluginLoader::readElfDynamicInfo(const QString &fileName, ElfDynamicInfo &info)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = file.size();
+    if (size < EI_NIDENT)
+        return false;
+
+    const uchar *data = file.map(0, size);
+    if (!data)
+        return false;
+
+    bool ret = false;
+    if (memcmp(data, ELFMAG, SELFMAG) == 0) {
+        // 只处理和当前进程字节序相同的文件，其他的也不可能被当前进程加载
+        const bool littleEndian = (QSysInfo::ByteOrder == QSysInfo::LittleEndian);
+        if (data[EI_DATA] == (littleEndian ? ELFDATA2LSB : ELFDATA2MSB)) {
+            if (data[EI_CLASS] == ELFCLASS64)
+                ret = readDynamicSection<Elf64_Ehdr, Elf64_Phdr, Elf64_Dyn>(data, size, info);
+            else if (data[EI_CLASS] == ELFCLASS32)
+                ret = readDynamicSection<Elf32_Ehdr, Elf32_Phdr, Elf32_Dyn>(data, size, info);
+        }
+    }
+
+    file.unmap(const_cast<uchar *>(data));
+    return ret;
 }
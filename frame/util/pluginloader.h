@@ -6,14 +6,24 @@
 #define PLUGINLOADER_H
 
 #include <QThread>
+#include <QStringList>
+
+#include <sys/types.h>
 
 class PluginLoader : public QThread
 {
     Q_OBJECT
 
 public:
+    struct ElfDynamicInfo {
+        QStringList needed;
+        QString soname;
+        QStringList runpaths;
+    };
+
     explicit PluginLoader(const QString &pluginDirPath, QObject *parent);
     static QString libUsedDtkCoreFileName(const QString &fileName);
+    static bool readElfDynamicInfo(const QString &fileName, ElfDynamicInfo &info);
     /**
      * @brief realFileName 获取软连接的真实文件的路径
      * @param fileName 文件地址
@@ -31,6 +41,15 @@ protected:
     QString dtkCoreFileName();
 
 private:
+    static QString findDtkCore(const QString &fileName, int depth);
+
+private:
+    struct DtkCoreCacheInfo {
+        ino_t inode;
+        time_t mtime;
+        QString dtkCore;
+    };
+
     QString m_pluginDirPath;
 };
 
@@ -0,0 +1,251 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "pluginmanifest.h"
+#include "pluginloader.h"
+
+#include <QApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QPluginLoader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QDebug>
+
+#include <sys/stat.h>
+
+// 缓存内容变化时需要修改版本号，旧文件会被忽略
+#define MANIFEST_VERSION 1
+
+PluginManifest::PluginManifest(QObject *parent)
+    : QObject(parent)
+    , m_saveTimer(new QTimer(this))
+{
+    // 可能在加载插件的线程中第一次被调用，保证定时器在主线程中运行
+    if (qApp)
+        moveToThread(qApp->thread());
+
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(3000);
+
+    connect(m_saveTimer, &QTimer::timeout, this, &PluginManifest::save);
+}
+
+/**
+ * @brief PluginManifest::metaData 获取插件的元数据，不需要加载插件库
+ * @param pluginFile 插件文件路径
+ * @return 和QPluginLoader::metaData相同
+ */
+QJsonObject PluginManifest::metaData(const QString &pluginFile)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const QJsonObject &e = entry(pluginFile);
+        if (e.contains("metaData"))
+            return e.value("metaData").toObject();
+    }
+
+    // QPluginLoader::metaData只读取文件中的元数据段，不会dlopen插件
+    const QJsonObject &meta = QPluginLoader(pluginFile).metaData();
+
+    QMutexLocker locker(&m_mutex);
+    entry(pluginFile).insert("metaData", meta);
+    markDirty(pluginFile);
+
+    return meta;
+}
+
+/**
+ * @brief PluginManifest::dtkCore 获取插件依赖的dtkcore库
+ * @param pluginFile 插件文件路径
+ * @return dtkcore库的SONAME，不依赖dtkcore时返回空
+ */
+QString PluginManifest::dtkCore(const QString &pluginFile)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const QJsonObject &e = entry(pluginFile);
+        if (e.contains("dtkCore"))
+            return e.value("dtkCore").toString();
+    }
+
+    const QString &dtkCore = PluginLoader::libUsedDtkCoreFileName(pluginFile);
+
+    QMutexLocker locker(&m_mutex);
+    entry(pluginFile).insert("dtkCore", dtkCore);
+    markDirty(pluginFile);
+
+    return dtkCore;
+}
+
+/**
+ * @brief PluginManifest::pluginName
+ * @return 插件上一次被加载时的插件名，没有加载过时返回空
+ */
+QString PluginManifest::pluginName(const QString &pluginFile)
+{
+    QMutexLocker locker(&m_mutex);
+    return entry(pluginFile).value("pluginName").toString();
+}
+
+QString PluginManifest::pluginDisplayName(const QString &pluginFile)
+{
+    QMutexLocker locker(&m_mutex);
+    return entry(pluginFile).value("pluginDisplayName").toString();
+}
+
+bool PluginManifest::pluginAllowDisable(const QString &pluginFile)
+{
+    QMutexLocker locker(&m_mutex);
+    return entry(pluginFile).value("pluginAllowDisable").toBool();
+}
+
+PluginsItemInterface::PluginType PluginManifest::pluginType(const QString &pluginFile)
+{
+    QMutexLocker locker(&m_mutex);
+    return PluginsItemInterface::PluginType(entry(pluginFile).value("pluginType").toInt(PluginsItemInterface::Normal));
+}
+
+/**
+ * @brief PluginManifest::setPluginInfo 插件加载后记录插件名等信息，下次启动时不加载插件库也可以获取
+ * @note 这里获取的信息不依赖于插件的init函数
+ */
+void PluginManifest::setPluginInfo(const QString &pluginFile, PluginsItemInterface *interface)
+{
+    QJsonObject info;
+    info.insert("pluginName", interface->pluginName());
+    info.insert("pluginDisplayName", interface->pluginDisplayName());
+    info.insert("pluginAllowDisable", interface->pluginIsAllowDisable());
+    info.insert("pluginType", int(interface->type()));
+
+    QMutexLocker locker(&m_mutex);
+    QJsonObject &e = entry(pluginFile);
+
+    bool changed = false;
+    for (auto it = info.constBegin(); it != info.constEnd(); ++it) {
+        if (e.value(it.key()) != it.value()) {
+            e.insert(it.key(), it.value());
+            changed = true;
+        }
+    }
+
+    if (changed)
+        markDirty(pluginFile);
+}
+
+/**
+ * @brief PluginManifest::probe 在加载插件的线程中预先读取插件的元数据和依赖的dtkcore库
+ * @param pluginFile 插件文件路径
+ * @return 插件依赖的dtkcore库
+ */
+QString PluginManifest::probe(const QString &pluginFile)
+{
+    PluginManifest *manifest = PluginManifest::instance();
+    manifest->metaData(pluginFile);
+    return manifest->dtkCore(pluginFile);
+}
+
+QString PluginManifest::manifestFilePath(const QString &pluginDirPath)
+{
+    const QByteArray &hash = QCryptographicHash::hash(QDir(pluginDirPath).absolutePath().toUtf8(), QCryptographicHash::Md5).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/dde-dock/plugin-manifest-" + hash + ".json";
+}
+
+/**
+ * @brief PluginManifest::save 将有变化的插件目录的缓存写入文件，每个插件目录对应一个文件
+ */
+void PluginManifest::save()
+{
+    QMutexLocker locker(&m_mutex);
+
+    for (const QString &dirPath : m_dirtyDirs) {
+        QJsonObject plugins;
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            if (QFileInfo(it.key()).absolutePath() == dirPath && !it.value().isEmpty())
+                plugins.insert(it.key(), it.value());
+        }
+
+        QJsonObject root;
+        root.insert("version", MANIFEST_VERSION);
+        root.insert("plugins", plugins);
+
+        const QString &filePath = manifestFilePath(dirPath);
+        QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+        QSaveFile file(filePath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "open plugin manifest failed:" << filePath << file.errorString();
+            continue;
+        }
+
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        if (!file.commit())
+            qWarning() << "write plugin manifest failed:" << filePath << file.errorString();
+    }
+
+    m_dirtyDirs.clear();
+}
+
+/**
+ * @brief PluginManifest::entry 获取插件的缓存信息，插件文件变化时清空
+ * @note 调用时需要持有m_mutex
+ */
+QJsonObject &PluginManifest::entry(const QString &pluginFile)
+{
+    loadDir(QFileInfo(pluginFile).absolutePath());
+
+    QJsonObject &e = m_entries[pluginFile];
+
+    struct stat st;
+    if (stat(pluginFile.toLocal8Bit().constData(), &st) != 0) {
+        e = QJsonObject();
+        return e;
+    }
+
+    const double inode = double(st.st_ino);
+    const double mtime = double(st.st_mtime);
+    const double size = double(st.st_size);
+    if (e.value("inode").toDouble() != inode || e.value("mtime").toDouble() != mtime || e.value("size").toDouble() != size) {
+        e = QJsonObject();
+        e.insert("inode", inode);
+        e.insert("mtime", mtime);
+        e.insert("size", size);
+        markDirty(pluginFile);
+    }
+
+    return e;
+}
+
+void PluginManifest::loadDir(const QString &pluginDirPath)
+{
+    if (m_loadedDirs.contains(pluginDirPath))
+        return;
+
+    m_loadedDirs.insert(pluginDirPath);
+
+    QFile file(manifestFilePath(pluginDirPath));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    const QJsonObject &root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value("version").toInt() != MANIFEST_VERSION)
+        return;
+
+    const QJsonObject &plugins = root.value("plugins").toObject();
+    for (auto it = plugins.constBegin(); it != plugins.constEnd(); ++it) {
+        if (!m_entries.contains(it.key()))
+            m_entries.insert(it.key(), it.value().toObject());
+    }
+}
+
+void PluginManifest::markDirty(const QString &pluginFile)
+{
+    m_dirtyDirs.insert(QFileInfo(pluginFile).absolutePath());
+
+    // 可能在加载插件的线程中调用
+    QMetaObject::invokeMethod(m_saveTimer, "start", Qt::QueuedConnection);
+}
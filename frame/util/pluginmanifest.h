@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef PLUGINMANIFEST_H
+#define PLUGINMANIFEST_H
+
+#include "singleton.h"
+#include "pluginsiteminterface.h"
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QJsonObject>
+
+class QTimer;
+
+/**
+ * @brief The PluginManifest class
+ * @note 缓存插件的元数据(QPluginLoader::metaData)、依赖的dtkcore、插件名等信息，按插件目录保存到$XDG_CACHE_HOME/dde-dock下，
+ * @note 以(inode, 修改时间, 文件大小)判断插件文件是否变化，插件文件不变时不需要再读取或加载插件库就可以判断插件是否兼容
+ */
+class PluginManifest : public QObject, public Singleton<PluginManifest>
+{
+    Q_OBJECT
+    friend class Singleton<PluginManifest>;
+
+public:
+    QJsonObject metaData(const QString &pluginFile);
+    QString dtkCore(const QString &pluginFile);
+    QString pluginName(const QString &pluginFile);
+    QString pluginDisplayName(const QString &pluginFile);
+    bool pluginAllowDisable(const QString &pluginFile);
+    PluginsItemInterface::PluginType pluginType(const QString &pluginFile);
+    void setPluginInfo(const QString &pluginFile, PluginsItemInterface *interface);
+
+    static QString probe(const QString &pluginFile);
+    static QString manifestFilePath(const QString &pluginDirPath);
+
+public Q_SLOTS:
+    void save();
+
+private:
+    explicit PluginManifest(QObject *parent = nullptr);
+
+    QJsonObject &entry(const QString &pluginFile);
+    void loadDir(const QString &pluginDirPath);
+    void markDirty(const QString &pluginFile);
+
+private:
+    QMutex m_mutex;
+    QTimer *m_saveTimer;
+
+    QHash<QString, QJsonObject> m_entries;      // 插件文件路径 -> 缓存的信息
+    QSet<QString> m_loadedDirs;
+    QSet<QString> m_dirtyDirs;
+};
+
+#endif // PLUGINMANIFEST_H
@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "pluginstub.h"
+
+// 和各个插件中保存启用状态的键值一致
+#define PLUGIN_STATE_KEY    "enable"
+
+PluginStub::PluginStub(const QString &pluginFile, const QString &name, const QString &displayName, PluginType type)
+    : QObject(nullptr)
+    , m_pluginFile(pluginFile)
+    , m_pluginName(name)
+    , m_pluginDisplayName(displayName)
+    , m_pluginType(type)
+{
+}
+
+const QString PluginStub::pluginName() const
+{
+    return m_pluginName;
+}
+
+const QString PluginStub::pluginDisplayName() const
+{
+    return m_pluginDisplayName;
+}
+
+void PluginStub::init(PluginProxyInterface *proxyInter)
+{
+    m_proxyInter = proxyInter;
+}
+
+QWidget *PluginStub::itemWidget(const QString &itemKey)
+{
+    Q_UNUSED(itemKey);
+
+    return nullptr;
+}
+
+bool PluginStub::pluginIsAllowDisable()
+{
+    return true;
+}
+
+bool PluginStub::pluginIsDisable()
+{
+    return !m_proxyInter || !m_proxyInter->getValue(this, PLUGIN_STATE_KEY, true).toBool();
+}
+
+void PluginStub::pluginStateSwitched()
+{
+    // 只有被禁用的插件才会使用占位对象，切换状态即为启用插件
+    Q_EMIT activateRequested(true);
+}
+
+void PluginStub::pluginSettingsChanged()
+{
+    // 其他地方修改了配置，插件被启用
+    if (!pluginIsDisable())
+        Q_EMIT activateRequested(false);
+}
+
+PluginsItemInterface::PluginType PluginStub::type()
+{
+    return m_pluginType;
+}
+
+QString PluginStub::pluginFile() const
+{
+    return m_pluginFile;
+}
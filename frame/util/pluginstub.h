@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef PLUGINSTUB_H
+#define PLUGINSTUB_H
+
+#include "pluginsiteminterface.h"
+
+#include <QObject>
+
+/**
+ * @brief The PluginStub class
+ * @note 被禁用的插件启动时不加载插件库，使用缓存的插件信息构造一个占位对象，
+ * @note 插件被重新启用时发出activateRequested信号，由插件管理类加载真正的插件
+ */
+class PluginStub : public QObject, public PluginsItemInterface
+{
+    Q_OBJECT
+
+public:
+    explicit PluginStub(const QString &pluginFile, const QString &name, const QString &displayName, PluginType type);
+
+    const QString pluginName() const override;
+    const QString pluginDisplayName() const override;
+    void init(PluginProxyInterface *proxyInter) override;
+    QWidget *itemWidget(const QString &itemKey) override;
+
+    bool pluginIsAllowDisable() override;
+    bool pluginIsDisable() override;
+    void pluginStateSwitched() override;
+    void pluginSettingsChanged() override;
+    PluginType type() override;
+
+    QString pluginFile() const;
+
+Q_SIGNALS:
+    void activateRequested(bool switchState);
+
+private:
+    const QString m_pluginFile;
+    const QString m_pluginName;
+    const QString m_pluginDisplayName;
+    const PluginType m_pluginType;
+};
+
+#endif // PLUGINSTUB_H
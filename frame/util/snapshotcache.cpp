@@ -0,0 +1,164 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "snapshotcache.h"
+
+#include <QApplication>
+#include <QDateTime>
+#include <QX11Info>
+#include <QDebug>
+
+#include <xcb/xcb.h>
+#include <xcb/damage.h>
+
+// 8个窗口的预览图按2倍缩放计算约为3M，保留最近使用的若干个应用的截图
+#define SNAPSHOT_CACHE_MAX_BYTES (16 * 1024 * 1024)
+// 没有Damage扩展(如wayland)时只能依赖超时失效
+#define SNAPSHOT_CACHE_MAX_AGE (30 * 1000)
+
+SnapshotCache::SnapshotCache(QObject *parent)
+    : QObject(parent)
+    , m_bytes(0)
+    , m_maxBytes(SNAPSHOT_CACHE_MAX_BYTES)
+    , m_maxAge(SNAPSHOT_CACHE_MAX_AGE)
+    , m_damageEventBase(0)
+    , m_hits(0)
+    , m_misses(0)
+{
+    initDamage();
+}
+
+/**
+ * @brief SnapshotCache::find 查找窗口缓存的截图
+ * @param size 截图缩放时的目标大小，和缓存时不同则不能命中
+ * @return 缓存存在且窗口内容没有变化时返回true
+ */
+bool SnapshotCache::find(WId wid, const QSize &size, QImage &image, QRectF &srcRect)
+{
+    auto it = m_entries.find(wid);
+    if (it == m_entries.end() || it->size != size) {
+        m_misses++;
+        return false;
+    }
+
+    if (QDateTime::currentMSecsSinceEpoch() - it->timestamp > m_maxAge) {
+        remove(wid);
+        m_misses++;
+        return false;
+    }
+
+    image = it->image;
+    srcRect = it->srcRect;
+
+    m_lruList.removeOne(wid);
+    m_lruList.append(wid);
+
+    m_hits++;
+    return true;
+}
+
+void SnapshotCache::insert(WId wid, const QSize &size, const QImage &image, const QRectF &srcRect)
+{
+    remove(wid);
+
+    const qint64 imageBytes = image.sizeInBytes();
+    if (image.isNull() || imageBytes > m_maxBytes)
+        return;
+
+    // 超出大小时淘汰最久没有使用的截图
+    while (!m_lruList.isEmpty() && m_bytes + imageBytes > m_maxBytes)
+        remove(m_lruList.first());
+
+    Entry entry;
+    entry.image = image;
+    entry.srcRect = srcRect;
+    entry.size = size;
+    entry.timestamp = QDateTime::currentMSecsSinceEpoch();
+    entry.damage = createDamage(wid);
+
+    m_entries.insert(wid, entry);
+    m_lruList.append(wid);
+    m_bytes += imageBytes;
+}
+
+void SnapshotCache::remove(WId wid)
+{
+    auto it = m_entries.find(wid);
+    if (it == m_entries.end())
+        return;
+
+    destroyDamage(it->damage);
+    m_bytes -= it->image.sizeInBytes();
+    m_entries.erase(it);
+    m_lruList.removeOne(wid);
+}
+
+bool SnapshotCache::nativeEventFilter(const QByteArray &eventType, void *message, long *result)
+{
+    Q_UNUSED(result);
+
+    if (!m_damageEventBase || eventType != "xcb_generic_event_t")
+        return false;
+
+    xcb_generic_event_t *event = static_cast<xcb_generic_event_t *>(message);
+    if ((event->response_type & ~0x80) != m_damageEventBase + XCB_DAMAGE_NOTIFY)
+        return false;
+
+    // 窗口内容发生变化，缓存的截图失效
+    xcb_damage_notify_event_t *notify = reinterpret_cast<xcb_damage_notify_event_t *>(event);
+    if (m_entries.contains(notify->drawable) && m_entries.value(notify->drawable).damage == notify->damage)
+        remove(notify->drawable);
+
+    return false;
+}
+
+void SnapshotCache::initDamage()
+{
+    if (!QX11Info::isPlatformX11() || !QX11Info::connection())
+        return;
+
+    xcb_connection_t *connection = QX11Info::connection();
+    const xcb_query_extension_reply_t *extension = xcb_get_extension_data(connection, &xcb_damage_id);
+    if (!extension || !extension->present) {
+        qWarning() << "damage extension is not supported, snapshot cache will expire by time only";
+        return;
+    }
+
+    // 使用Damage扩展前需要先协商版本
+    xcb_damage_query_version_reply_t *reply = xcb_damage_query_version_reply(connection,
+                                                                             xcb_damage_query_version(connection, XCB_DAMAGE_MAJOR_VERSION, XCB_DAMAGE_MINOR_VERSION),
+                                                                             nullptr);
+    if (!reply)
+        return;
+
+    free(reply);
+
+    m_damageEventBase = extension->first_event;
+    qApp->installNativeEventFilter(this);
+}
+
+quint32 SnapshotCache::createDamage(WId wid)
+{
+    if (!m_damageEventBase)
+        return 0;
+
+    xcb_connection_t *connection = QX11Info::connection();
+    const xcb_damage_damage_t damage = xcb_generate_id(connection);
+    // 只需要知道窗口内容是否变化，NON_EMPTY级别下只会收到一次通知
+    xcb_damage_create(connection, damage, xcb_drawable_t(wid), XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+    xcb_flush(connection);
+
+    return damage;
+}
+
+void SnapshotCache::destroyDamage(quint32 damage)
+{
+    if (!damage || !m_damageEventBase)
+        return;
+
+    // 窗口销毁时Damage对象会被一起销毁，此时的错误直接忽略
+    xcb_connection_t *connection = QX11Info::connection();
+    xcb_discard_reply(connection, xcb_damage_destroy_checked(connection, damage).sequence);
+    xcb_flush(connection);
+}
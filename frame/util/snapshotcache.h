@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef SNAPSHOTCACHE_H
+#define SNAPSHOTCACHE_H
+
+#include "singleton.h"
+
+#include <QObject>
+#include <QAbstractNativeEventFilter>
+#include <QHash>
+#include <QList>
+#include <QImage>
+#include <QRectF>
+
+/**
+ * @brief The SnapshotCache class
+ * @note 按窗口ID缓存预览窗口中已经缩放好的窗口截图，按最近使用顺序淘汰，总大小不超过m_maxBytes，
+ * @note 通过X Damage监听被缓存的窗口，窗口内容变化或超过m_maxAge后缓存失效
+ */
+class SnapshotCache : public QObject, public QAbstractNativeEventFilter, public Singleton<SnapshotCache>
+{
+    Q_OBJECT
+    friend class Singleton<SnapshotCache>;
+
+public:
+    bool find(WId wid, const QSize &size, QImage &image, QRectF &srcRect);
+    void insert(WId wid, const QSize &size, const QImage &image, const QRectF &srcRect);
+    void remove(WId wid);
+
+    qint64 bytes() const { return m_bytes; }
+    int hits() const { return m_hits; }
+    int misses() const { return m_misses; }
+
+protected:
+    bool nativeEventFilter(const QByteArray &eventType, void *message, long *result) override;
+
+private:
+    explicit SnapshotCache(QObject *parent = nullptr);
+
+    void initDamage();
+    quint32 createDamage(WId wid);
+    void destroyDamage(quint32 damage);
+
+private:
+    struct Entry {
+        QImage image;
+        QRectF srcRect;
+        QSize size;             // 截图缩放时的目标大小
+        qint64 timestamp;
+        quint32 damage;
+    };
+
+    QHash<WId, Entry> m_entries;
+    QList<WId> m_lruList;       // 最近使用的窗口在最后
+
+    qint64 m_bytes;
+    qint64 m_maxBytes;
+    qint64 m_maxAge;            // 毫秒
+    quint8 m_damageEventBase;   // 为0时表示不支持Damage扩展
+
+    int m_hits;
+    int m_misses;
+};
+
+#endif // SNAPSHOTCACHE_H
@@ -0,0 +1,172 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "startuptracer.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QDebug>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define TRACE_FILE_ENV "DDE_DOCK_TRACE_FILE"
+#define TRACER_PROPERTY "_d_dock_startup_tracer"
+
+StartupTracer::StartupTracer()
+    : m_enabled(!qEnvironmentVariableIsEmpty(TRACE_FILE_ENV))
+{
+    m_timer.start();
+}
+
+/**
+ * @brief StartupTracer::instance
+ * @note 托盘插件中也会编译这个文件，通过qApp的属性共享任务栏进程中的实例，保证所有记录输出到同一个文件中
+ */
+StartupTracer *StartupTracer::instance()
+{
+    static StartupTracer *tracer = nullptr;
+    static bool shared = false;
+    if (shared)
+        return tracer;
+
+    if (!tracer && qApp) {
+        const QVariant &value = qApp->property(TRACER_PROPERTY);
+        if (value.isValid())
+            tracer = reinterpret_cast<StartupTracer *>(value.value<quintptr>());
+    }
+
+    if (!tracer)
+        tracer = new StartupTracer;
+
+    // main函数开始时qApp还没有创建，创建后再设置属性
+    if (qApp) {
+        if (!qApp->property(TRACER_PROPERTY).isValid())
+            qApp->setProperty(TRACER_PROPERTY, QVariant::fromValue(reinterpret_cast<quintptr>(tracer)));
+        shared = true;
+    }
+
+    return tracer;
+}
+
+/**
+ * @brief StartupTracer::start 清空之前的记录并开始记录
+ */
+void StartupTracer::start()
+{
+    QMutexLocker locker(&m_mutex);
+    m_events.clear();
+    m_enabled = true;
+}
+
+void StartupTracer::stop()
+{
+    m_enabled = false;
+}
+
+void StartupTracer::addEvent(const char *name, const QString &detail, const char *category, qint64 begin, qint64 end)
+{
+    if (!isEnabled())
+        return;
+
+    const Event event { QString::fromLatin1(name), detail, category, begin, end - begin, qint64(syscall(SYS_gettid)) };
+
+    QMutexLocker locker(&m_mutex);
+    m_events.append(event);
+}
+
+QByteArray StartupTracer::toJson() const
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+
+    QJsonObject processName;
+    processName.insert("name", "process_name");
+    processName.insert("ph", "M");
+    processName.insert("pid", pid);
+    processName.insert("args", QJsonObject { { "name", "dde-dock" } });
+    traceEvents.append(processName);
+
+    QMutexLocker locker(&m_mutex);
+    for (const Event &event : m_events) {
+        QJsonObject obj;
+        obj.insert("name", event.detail.isEmpty() ? event.name : QString("%1 %2").arg(event.name).arg(event.detail));
+        obj.insert("cat", event.category);
+        obj.insert("ph", "X");
+        obj.insert("ts", event.begin);
+        obj.insert("dur", event.duration);
+        obj.insert("pid", pid);
+        obj.insert("tid", event.threadId);
+        if (!event.detail.isEmpty())
+            obj.insert("args", QJsonObject { { "detail", event.detail } });
+
+        traceEvents.append(obj);
+    }
+
+    QJsonObject root;
+    root.insert("traceEvents", traceEvents);
+    root.insert("displayTimeUnit", "ms");
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+/**
+ * @brief StartupTracer::dump 将记录写入文件
+ * @param filePath 输出文件路径
+ * @return 是否写入成功
+ */
+bool StartupTracer::dump(const QString &filePath) const
+{
+    if (filePath.isEmpty())
+        return false;
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "open trace file failed:" << filePath << file.errorString();
+        return false;
+    }
+
+    file.write(toJson());
+    return file.commit();
+}
+
+/**
+ * @brief StartupTracer::dumpToEnvFile 写入环境变量DDE_DOCK_TRACE_FILE指定的文件，没有设置时不处理
+ */
+bool StartupTracer::dumpToEnvFile() const
+{
+    if (!isEnabled() || qEnvironmentVariableIsEmpty(TRACE_FILE_ENV))
+        return false;
+
+    return dump(qEnvironmentVariable(TRACE_FILE_ENV));
+}
+
+TraceSpan::TraceSpan(const char *name, const QString &detail, const char *category)
+    : m_name(name)
+    , m_category(category)
+    , m_begin(-1)
+{
+    StartupTracer *tracer = StartupTracer::instance();
+    if (tracer->isEnabled()) {
+        m_detail = detail;
+        m_begin = tracer->now();
+    }
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (m_begin < 0)
+        return;
+
+    StartupTracer *tracer = StartupTracer::instance();
+    tracer->addEvent(m_name, m_detail, m_category, m_begin, tracer->now());
+}
@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef STARTUPTRACER_H
+#define STARTUPTRACER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+/**
+ * @brief The StartupTracer class
+ * @note 记录启动过程中各个阶段的耗时，输出为Chrome trace-event格式的json，可以在chrome://tracing或Perfetto中查看
+ * @note 设置环境变量DDE_DOCK_TRACE_FILE为输出文件路径时从启动开始记录，也可以通过DBus接口StartTrace/StopTrace记录
+ */
+class StartupTracer
+{
+public:
+    struct Event {
+        QString name;
+        QString detail;
+        const char *category;
+        qint64 begin;               // 微秒
+        qint64 duration;            // 微秒
+        qint64 threadId;
+    };
+
+    static StartupTracer *instance();
+
+    inline bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    inline qint64 now() const { return m_timer.nsecsElapsed() / 1000; }
+
+    void start();
+    void stop();
+    void addEvent(const char *name, const QString &detail, const char *category, qint64 begin, qint64 end);
+
+    QByteArray toJson() const;
+    bool dump(const QString &filePath) const;
+    bool dumpToEnvFile() const;
+
+private:
+    StartupTracer();
+
+private:
+    std::atomic<bool> m_enabled;
+    QElapsedTimer m_timer;
+
+    mutable QMutex m_mutex;
+    QVector<Event> m_events;
+};
+
+/**
+ * @brief The TraceSpan class
+ * @note 在作用域内记录一个阶段，没有开启记录时只有一次原子读取的开销
+ */
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name, const QString &detail = QString(), const char *category = "startup");
+    ~TraceSpan();
+
+private:
+    const char *m_name;
+    QString m_detail;
+    const char *m_category;
+    qint64 m_begin;
+};
+
+#endif // STARTUPTRACER_H
@@ -4,6 +4,9 @@
 
 #include "themeappicon.h"
 #include "imageutil.h"
+#include "themeiconresolver.h"
+#include "icondiskcache.h"
+#include "iconresizepolicy.h"
 
 #include <QIcon>
 #include <QFile>
@@ -15,7 +18,6 @@
 #include <QDate>
 #include <QPainter>
 #include <QStandardPaths>
-#include <QProcess>
 
 #include <private/qguiapplication_p.h>
 #include <private/qiconloader_p.h>
@@ -36,33 +38,15 @@ ThemeAppIcon::~ThemeAppIcon()
  * @param name 图标名
  * @return 获取到的图标
  * @note 只有在正常查找图标失败时，才走这个逻辑，如果直接使用QIcon::fromTheme可以获取到图标，是没必要的
+ * @note 这里是同步查找，界面线程中应优先使用ThemeIconResolver::resolveImage在后台线程中查找
  */
 QIcon ThemeAppIcon::getIcon(const QString &name)
 {
-    //TODO 这里找图标会耗时，界面轻微卡顿，后面有时间可以放到AppItem里面，单独开启线程去查找
-    QProcess process;
-    process.start("qtxdg-iconfinder", QStringList() << name);
-    process.closeWriteChannel();
-    process.waitForFinished();
-
-    int exitCode = process.exitCode();
-    QString outputTxt = process.readAllStandardOutput();
-
-    auto list = outputTxt.split("\n");
-
-    if (exitCode != 0 || list.size() <= 3)
+    const QString &path = ThemeIconResolver::instance()->lookup(name, 48);
+    if (path.isEmpty())
         return QIcon::fromTheme(name);
 
-    // 去掉无用数据
-    list.removeFirst();
-    list.removeLast();
-    list.removeLast();
-
-    for (auto &s : list) {
-        s = s.simplified();
-    }
-
-    return QIcon::fromTheme(list.first());
+    return QIcon(path);
 }
 
 bool ThemeAppIcon::getIcon(QPixmap &pix, const QString iconName, const int size, bool reObtain)
@@ -71,6 +55,7 @@ bool ThemeAppIcon::getIcon(QPixmap &pix, const QString iconName, const int size,
     QString key;
     QIcon icon;
     bool ret = true;
+    bool saveToDiskCache = false;
     // 把size改为小于size的最大偶数 :)
     const int s = int(size * qApp->devicePixelRatio()) & ~1;
 
@@ -115,6 +100,10 @@ bool ThemeAppIcon::getIcon(QPixmap &pix, const QString iconName, const int size,
                 break;
         }
 
+        // load pixmap from disk cache, 缓存中的图标已经是s大小，不需要再解析svg
+        if (IconDiskCache::instance()->find(tmpName, s, qApp->devicePixelRatio(), pix))
+            break;
+
         // 重新从主题中获取一次
 
         // 如果此提交我们使用的qt版本已经包含，那就可以不需要reObtain的逻辑了
@@ -130,10 +119,14 @@ bool ThemeAppIcon::getIcon(QPixmap &pix, const QString iconName, const int size,
         }
 
         // load pixmap from Icon-Theme
-        const int fakeSize = std::max(48, s); // cannot use 16x16, cause 16x16 is label icon
+        // cannot use 16x16, cause 16x16 is label icon
+        // 按照档位渲染，同一档位内QIcon会复用已经渲染过的图像，只需要再缩放到实际大小
+        const int fakeSize = IconResizePolicy::sizeBucket(std::max(48, s));
         pix = icon.pixmap(QSize(fakeSize, fakeSize));
-        if (!pix.isNull())
+        if (!pix.isNull()) {
+            saveToDiskCache = ret;
             break;
+        }
 
         // fallback to a Default pixmap
         pix = QPixmap(":/icons/resources/application-x-desktop.svg");
@@ -149,6 +142,9 @@ bool ThemeAppIcon::getIcon(QPixmap &pix, const QString iconName, const int size,
     }
     pix.setDevicePixelRatio(qApp->devicePixelRatio());
 
+    if (saveToDiskCache)
+        IconDiskCache::instance()->insert(tmpName, s, qApp->devicePixelRatio(), pix);
+
     return ret;
 }
 
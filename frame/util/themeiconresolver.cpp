@@ -0,0 +1,434 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "themeiconresolver.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QIcon>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QSettings>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <QDebug>
+
+#include <DApplication>
+
+#include <climits>
+#include <cstring>
+
+DWIDGET_USE_NAMESPACE
+
+/**
+ * @brief The GtkIconCache class
+ * @note 读取gtk-update-icon-cache生成的icon-theme.cache文件，通过哈希表直接得到图标所在的子目录，
+ * @note 避免对主题下的每个目录逐一stat，文件格式与Qt中QIconCacheGtkReader的解析方式一致
+ */
+class GtkIconCache
+{
+public:
+    explicit GtkIconCache(const QString &themeDir);
+
+    bool isValid() const { return m_data != nullptr; }
+    QSet<QString> directories(const QString &iconName) const;
+
+private:
+    quint16 read16(quint32 offset) const;
+    quint32 read32(quint32 offset) const;
+
+private:
+    QFile m_file;
+    const uchar *m_data;
+    quint32 m_size;
+};
+
+GtkIconCache::GtkIconCache(const QString &themeDir)
+    : m_file(themeDir + "/icon-theme.cache")
+    , m_data(nullptr)
+    , m_size(0)
+{
+    const QFileInfo cacheInfo(m_file);
+    if (!cacheInfo.exists())
+        return;
+
+    // 缓存文件比主题目录旧时，说明目录被修改过而缓存没有更新，不能使用
+    if (cacheInfo.lastModified() < QFileInfo(themeDir).lastModified())
+        return;
+
+    if (!m_file.open(QIODevice::ReadOnly))
+        return;
+
+    m_size = static_cast<quint32>(m_file.size());
+    m_data = m_file.map(0, m_size);
+    if (!m_data || m_size < 12 || read16(0) != 1) {
+        m_data = nullptr;
+        m_file.close();
+    }
+}
+
+quint16 GtkIconCache::read16(quint32 offset) const
+{
+    if (offset > m_size - 2 || (offset & 0x1))
+        return 0;
+
+    return qFromBigEndian<quint16>(m_data + offset);
+}
+
+quint32 GtkIconCache::read32(quint32 offset) const
+{
+    if (offset > m_size - 4 || (offset & 0x3))
+        return 0;
+
+    return qFromBigEndian<quint32>(m_data + offset);
+}
+
+static quint32 iconNameHash(const char *p)
+{
+    quint32 h = static_cast<signed char>(*p);
+    for (p += 1; *p != '\0'; p++)
+        h = (h << 5) - h + *p;
+
+    return h;
+}
+
+/**
+ * @brief GtkIconCache::directories
+ * @param iconName 图标名
+ * @return 包含该图标的子目录(相对主题目录)，找不到时返回空
+ */
+QSet<QString> GtkIconCache::directories(const QString &iconName) const
+{
+    QSet<QString> dirs;
+    if (!isValid())
+        return dirs;
+
+    const QByteArray name = iconName.toUtf8();
+    const quint32 hashOffset = read32(4);
+    const quint32 bucketCount = read32(hashOffset);
+    if (bucketCount == 0)
+        return dirs;
+
+    quint32 bucketOffset = read32(hashOffset + 4 + (iconNameHash(name.constData()) % bucketCount) * 4);
+    while (bucketOffset > 0 && bucketOffset <= m_size - 12) {
+        const quint32 nameOffset = read32(bucketOffset + 4);
+        if (nameOffset < m_size && qstrncmp(reinterpret_cast<const char *>(m_data + nameOffset), name.constData(), int(m_size - nameOffset)) == 0) {
+            const quint32 dirListOffset = read32(8);
+            const quint32 dirListLength = read32(dirListOffset);
+            const quint32 imageListOffset = read32(bucketOffset + 8);
+            const quint32 imageListLength = read32(imageListOffset);
+            if (imageListOffset + 4 + 8 * imageListLength > m_size)
+                return dirs;
+
+            for (quint32 i = 0; i < imageListLength; ++i) {
+                const quint16 dirIndex = read16(imageListOffset + 4 + 8 * i);
+                if (dirIndex >= dirListLength)
+                    continue;
+
+                const quint32 dirOffset = read32(dirListOffset + 4 + dirIndex * 4);
+                if (dirOffset >= m_size)
+                    continue;
+
+                dirs.insert(QString::fromUtf8(reinterpret_cast<const char *>(m_data + dirOffset)));
+            }
+            return dirs;
+        }
+
+        bucketOffset = read32(bucketOffset);
+    }
+
+    return dirs;
+}
+
+struct ThemeDirectory
+{
+    enum Type { Fixed, Scalable, Threshold };
+
+    QString path;
+    Type type = Threshold;
+    int size = 0;
+    int minSize = 0;
+    int maxSize = 0;
+    int threshold = 2;
+    int scale = 1;
+
+    // freedesktop图标主题规范中的DirectorySizeDistance，0表示尺寸匹配
+    int sizeDistance(int iconSize) const
+    {
+        const int scaledSize = size * scale;
+        switch (type) {
+        case Fixed:
+            return qAbs(scaledSize - iconSize);
+        case Scalable:
+            if (iconSize < minSize * scale)
+                return minSize * scale - iconSize;
+            if (iconSize > maxSize * scale)
+                return iconSize - maxSize * scale;
+            return 0;
+        case Threshold:
+            if (iconSize < (size - threshold) * scale)
+                return (size - threshold) * scale - iconSize;
+            if (iconSize > (size + threshold) * scale)
+                return iconSize - (size + threshold) * scale;
+            return 0;
+        }
+
+        return INT_MAX;
+    }
+};
+
+struct IconTheme
+{
+    QString name;
+    QStringList baseDirs;
+    QVector<QSharedPointer<GtkIconCache>> caches;      // 与baseDirs一一对应
+    QVector<ThemeDirectory> dirs;
+    QStringList parents;
+};
+
+ThemeIconResolver::ThemeIconResolver(QObject *parent)
+    : QObject(parent)
+    , m_searchPaths(QIcon::themeSearchPaths())
+    , m_themeName(QIcon::themeName())
+{
+    // 图标查找主要是磁盘IO，两个线程足够，避免启动时占满全局线程池
+    m_threadPool.setMaxThreadCount(2);
+
+    DApplication *app = qobject_cast<DApplication *>(qApp);
+    if (app) {
+        connect(app, &DApplication::iconThemeChanged, this, &ThemeIconResolver::clear);
+    }
+}
+
+/**
+ * @brief ThemeIconResolver::lookup 同步查找图标文件，可以在任意线程中调用
+ * @param iconName 图标名或者图标的绝对路径
+ * @param size 期望的图标像素大小
+ * @param themeName 图标主题名，为空时使用当前主题
+ * @return 图标文件的绝对路径，找不到时返回空
+ */
+QString ThemeIconResolver::lookup(const QString &iconName, int size, const QString &themeName)
+{
+    if (iconName.isEmpty())
+        return QString();
+
+    if (QDir::isAbsolutePath(iconName))
+        return QFileInfo::exists(iconName) ? iconName : QString();
+
+    QString theme = themeName;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (theme.isEmpty())
+            theme = m_themeName;
+
+        const QString key = QString("%1/%2@%3").arg(theme).arg(iconName).arg(size);
+        auto it = m_pathCache.constFind(key);
+        if (it != m_pathCache.constEnd())
+            return it.value();
+    }
+
+    QString path;
+    QString name = iconName;
+    while (path.isEmpty() && !name.isEmpty()) {
+        QSet<QString> visited;
+        path = findInTheme(theme, name, size, visited);
+        if (path.isEmpty())
+            path = findInTheme("hicolor", name, size, visited);
+        if (path.isEmpty())
+            path = findFallback(name);
+
+        // 与QIcon::fromTheme的处理保持一致，"a-b-c"找不到时依次尝试"a-b"和"a"
+        const int dashIndex = name.lastIndexOf('-');
+        name = dashIndex > 0 ? name.left(dashIndex) : QString();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_pathCache.insert(QString("%1/%2@%3").arg(theme).arg(iconName).arg(size), path);
+
+    return path;
+}
+
+/**
+ * @brief ThemeIconResolver::resolve 在后台线程中查找图标文件
+ * @return 图标文件路径，通过QFutureWatcher获取结果
+ */
+QFuture<QString> ThemeIconResolver::resolve(const QString &iconName, int size)
+{
+    return QtConcurrent::run(&m_threadPool, [ = ] {
+        return lookup(iconName, size);
+    });
+}
+
+/**
+ * @brief ThemeIconResolver::resolveImage 在后台线程中查找并光栅化图标
+ * @param pixelSize 图标的实际像素大小(已经乘以缩放比例)
+ * @return 光栅化后的图标，找不到时返回空的QImage
+ */
+QFuture<QImage> ThemeIconResolver::resolveImage(const QString &iconName, int pixelSize)
+{
+    return QtConcurrent::run(&m_threadPool, [ = ] {
+        const QString &path = lookup(iconName, pixelSize);
+        if (path.isEmpty())
+            return QImage();
+
+        // QPixmap只能在界面线程中使用，这里只生成QImage
+        QImageReader reader(path);
+        const QSize &size = reader.size();
+        if (size.isValid())
+            reader.setScaledSize(size.scaled(pixelSize, pixelSize, Qt::KeepAspectRatio));
+
+        QImage image = reader.read();
+        if (!image.isNull() && image.width() != pixelSize && image.height() != pixelSize)
+            image = image.scaled(pixelSize, pixelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+        return image;
+    });
+}
+
+/**
+ * @brief ThemeIconResolver::clear 图标主题变化时清空主题索引和查找结果
+ */
+void ThemeIconResolver::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_searchPaths = QIcon::themeSearchPaths();
+    m_themeName = QIcon::themeName();
+    m_themes.clear();
+    m_pathCache.clear();
+}
+
+QSharedPointer<IconTheme> ThemeIconResolver::loadTheme(const QString &themeName)
+{
+    QStringList searchPaths;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_themes.constFind(themeName);
+        if (it != m_themes.constEnd())
+            return it.value();
+
+        searchPaths = m_searchPaths;
+    }
+
+    QSharedPointer<IconTheme> theme(new IconTheme);
+    theme->name = themeName;
+
+    QString indexFile;
+    for (const QString &searchPath : searchPaths) {
+        const QString themeDir = searchPath + "/" + themeName;
+        if (!QFileInfo(themeDir).isDir())
+            continue;
+
+        theme->baseDirs << themeDir;
+        theme->caches << QSharedPointer<GtkIconCache>(new GtkIconCache(themeDir));
+
+        if (indexFile.isEmpty() && QFileInfo::exists(themeDir + "/index.theme"))
+            indexFile = themeDir + "/index.theme";
+    }
+
+    if (!indexFile.isEmpty()) {
+        QSettings index(indexFile, QSettings::IniFormat);
+        const QStringList &dirs = index.value("Icon Theme/Directories").toStringList()
+                + index.value("Icon Theme/ScaledDirectories").toStringList();
+        for (const QString &dir : dirs) {
+            ThemeDirectory themeDir;
+            themeDir.path = dir;
+            themeDir.size = index.value(dir + "/Size").toInt();
+            themeDir.minSize = index.value(dir + "/MinSize", themeDir.size).toInt();
+            themeDir.maxSize = index.value(dir + "/MaxSize", themeDir.size).toInt();
+            themeDir.threshold = index.value(dir + "/Threshold", 2).toInt();
+            themeDir.scale = qMax(1, index.value(dir + "/Scale", 1).toInt());
+
+            const QString &type = index.value(dir + "/Type", "Threshold").toString();
+            if (type == "Fixed")
+                themeDir.type = ThemeDirectory::Fixed;
+            else if (type == "Scalable")
+                themeDir.type = ThemeDirectory::Scalable;
+
+            if (themeDir.size > 0)
+                theme->dirs << themeDir;
+        }
+
+        theme->parents = index.value("Icon Theme/Inherits").toStringList();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_themes.insert(themeName, theme);
+
+    return theme;
+}
+
+QString ThemeIconResolver::findInTheme(const QString &themeName, const QString &iconName, int size, QSet<QString> &visited)
+{
+    if (themeName.isEmpty() || visited.contains(themeName))
+        return QString();
+
+    visited.insert(themeName);
+
+    static const QStringList suffixes { ".png", ".svg", ".xpm" };
+
+    QSharedPointer<IconTheme> theme = loadTheme(themeName);
+    QString closestPath;
+    int minDistance = INT_MAX;
+    for (int i = 0; i < theme->baseDirs.size() && minDistance > 0; ++i) {
+        const QString &baseDir = theme->baseDirs.at(i);
+        const GtkIconCache *cache = theme->caches.at(i).data();
+
+        // 缓存可用时只检查缓存中记录了该图标的目录
+        QSet<QString> cachedDirs;
+        if (cache->isValid()) {
+            cachedDirs = cache->directories(iconName);
+            if (cachedDirs.isEmpty())
+                continue;
+        }
+
+        for (const ThemeDirectory &dir : theme->dirs) {
+            if (cache->isValid() && !cachedDirs.contains(dir.path))
+                continue;
+
+            const int distance = dir.sizeDistance(size);
+            if (distance >= minDistance)
+                continue;
+
+            for (const QString &suffix : suffixes) {
+                const QString &filePath = baseDir + "/" + dir.path + "/" + iconName + suffix;
+                if (QFileInfo::exists(filePath)) {
+                    closestPath = filePath;
+                    minDistance = distance;
+                    break;
+                }
+            }
+
+            if (minDistance == 0)
+                break;
+        }
+    }
+
+    if (!closestPath.isEmpty())
+        return closestPath;
+
+    for (const QString &parent : theme->parents) {
+        const QString &path = findInTheme(parent, iconName, size, visited);
+        if (!path.isEmpty())
+            return path;
+    }
+
+    return QString();
+}
+
+QString ThemeIconResolver::findFallback(const QString &iconName) const
+{
+    static const QStringList suffixes { ".png", ".svg", ".xpm" };
+    static const QStringList fallbackDirs { "/usr/share/pixmaps" };
+
+    for (const QString &dir : fallbackDirs) {
+        for (const QString &suffix : suffixes) {
+            const QString &filePath = dir + "/" + iconName + suffix;
+            if (QFileInfo::exists(filePath))
+                return filePath;
+        }
+    }
+
+    return QString();
+}
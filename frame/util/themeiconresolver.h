@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef THEMEICONRESOLVER_H
+#define THEMEICONRESOLVER_H
+
+#include "singleton.h"
+
+#include <QObject>
+#include <QFuture>
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThreadPool>
+
+struct IconTheme;
+
+/**
+ * @brief The ThemeIconResolver class
+ * @note 在进程内按照freedesktop图标主题规范(index.theme和icon-theme.cache)查找图标文件
+ * @note 查找和光栅化都在独立的线程池中执行，替换之前在界面线程中同步调用qtxdg-iconfinder的方式
+ */
+class ThemeIconResolver : public QObject, public Singleton<ThemeIconResolver>
+{
+    Q_OBJECT
+    friend class Singleton<ThemeIconResolver>;
+
+public:
+    QString lookup(const QString &iconName, int size, const QString &themeName = QString());
+    QFuture<QString> resolve(const QString &iconName, int size);
+    QFuture<QImage> resolveImage(const QString &iconName, int pixelSize);
+
+public Q_SLOTS:
+    void clear();
+
+private:
+    explicit ThemeIconResolver(QObject *parent = nullptr);
+
+    QSharedPointer<IconTheme> loadTheme(const QString &themeName);
+    QString findInTheme(const QString &themeName, const QString &iconName, int size, QSet<QString> &visited);
+    QString findFallback(const QString &iconName) const;
+
+private:
+    QThreadPool m_threadPool;
+
+    QMutex m_mutex;
+    QStringList m_searchPaths;
+    QString m_themeName;
+    QHash<QString, QSharedPointer<IconTheme>> m_themes;
+    QHash<QString, QString> m_pathCache;            // 图标查找结果缓存(包括查找失败的结果)，主题变化时清空
+};
+
+#endif // THEMEICONRESOLVER_H
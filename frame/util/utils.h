@@ -11,6 +11,9 @@
 #include <QScreen>
 #include <QGSettings>
 #include <QDebug>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
 
 #include "imageutil.h"
 
@@ -73,6 +76,104 @@ inline QString qtify_name(const char *name)
     return result;
 }
 
+/**
+ * @brief The SettingsRegistry class
+ * 进程内共享的QGSettings，每个(schema_id, path)只创建一次，并缓存key列表和读取过的值，
+ * 配置变化时清除缓存的值，频繁调用SettingValue时只需要查找哈希表
+ */
+class SettingsRegistry
+{
+public:
+    static SettingsRegistry *instance()
+    {
+        // 不释放，避免程序退出时在QApplication之后析构QGSettings
+        static SettingsRegistry *registry = new SettingsRegistry;
+        return registry;
+    }
+
+    bool value(const QString &schema_id, const QByteArray &path, const QString &key, QVariant &value)
+    {
+        QMutexLocker locker(&m_mutex);
+        Entry *e = entry(schema_id, path);
+        auto it = e->values.constFind(key);
+        if (it != e->values.constEnd()) {
+            value = it.value();
+            return true;
+        }
+
+        if (!hasKey(e, key))
+            return false;
+
+        value = e->settings->get(key);
+        e->values.insert(key, value);
+        return true;
+    }
+
+    bool setValue(const QString &schema_id, const QByteArray &path, const QString &key, const QVariant &value)
+    {
+        Entry *e = nullptr;
+        {
+            QMutexLocker locker(&m_mutex);
+            e = entry(schema_id, path);
+            if (!hasKey(e, key))
+                return false;
+        }
+
+        // 本地写入时GSettings会同步发出changed信号，不能在加锁时调用set，否则信号处理中再次加锁会死锁
+        // Entry创建后不会释放，这里不加锁使用是安全的
+        e->settings->set(key, value);
+
+        QMutexLocker locker(&m_mutex);
+        e->values.remove(key);
+        return true;
+    }
+
+private:
+    struct Entry {
+        QGSettings *settings = nullptr;
+        QSet<QString> keys;
+        QHash<QString, QVariant> values;
+    };
+
+    SettingsRegistry() {}
+
+    static bool hasKey(const Entry *e, const QString &key)
+    {
+        return e->settings && (e->keys.contains(key) || e->keys.contains(qtify_name(key.toUtf8().data())));
+    }
+
+    Entry *entry(const QString &schema_id, const QByteArray &path)
+    {
+        Entry *&e = m_entries[schema_id + QLatin1Char('@') + QString::fromUtf8(path)];
+        if (e)
+            return e;
+
+        // schema不存在时也记录下来，不再重复查找
+        e = new Entry;
+        if (!QGSettings::isSchemaInstalled(schema_id.toUtf8()))
+            return e;
+
+        e->settings = new QGSettings(schema_id.toUtf8(), path);
+        // 可能在其他线程中第一次读取，配置变化的信号统一在主线程中处理
+        if (qApp && e->settings->thread() != qApp->thread())
+            e->settings->moveToThread(qApp->thread());
+
+        for (const QString &key : e->settings->keys())
+            e->keys.insert(key);
+
+        QObject::connect(e->settings, &QGSettings::changed, e->settings, [ this, e ] {
+            QMutexLocker locker(&m_mutex);
+            e->values.clear();
+        });
+
+        return e;
+    }
+
+private:
+    QMutex m_mutex;
+    QHash<QString, Entry *> m_entries;
+};
+
 /**
  * @brief SettingValue 根据给定信息返回获取的值
  * @param schema_id The id of the schema
@@ -83,40 +184,24 @@ inline QString qtify_name(const char *name)
  */
 inline const QVariant SettingValue(const QString &schema_id, const QByteArray &path = QByteArray(), const QString &key = QString(), const QVariant &fallback = QVariant())
 {
-    const QGSettings *settings = SettingsPtr(schema_id, path);
-
-    if (settings && ((settings->keys().contains(key)) || settings->keys().contains(qtify_name(key.toUtf8().data())))) {
-        QVariant v = settings->get(key);
-        delete settings;
-        return v;
-    } else{
-        qDebug() << "Cannot find gsettings, schema_id:" << schema_id
-                 << " path:" << path << " key:" << key
-                 << "Use fallback value:" << fallback;
-        // 如果settings->keys()不包含key则会存在内存泄露，所以需要释放
-        if (settings)
-            delete settings;
-
-        return fallback;
-    }
+    QVariant value;
+    if (SettingsRegistry::instance()->value(schema_id, path, key, value))
+        return value;
+
+    qDebug() << "Cannot find gsettings, schema_id:" << schema_id
+             << " path:" << path << " key:" << key
+             << "Use fallback value:" << fallback;
+    return fallback;
 }
 
 inline bool SettingSaveValue(const QString &schema_id, const QByteArray &path, const QString &key, const QVariant &value)
 {
-    QGSettings *settings = SettingsPtr(schema_id, path);
-
-    if (settings && ((settings->keys().contains(key)) || settings->keys().contains(qtify_name(key.toUtf8().data())))) {
-        settings->set(key, value);
-        delete settings;
+    if (SettingsRegistry::instance()->setValue(schema_id, path, key, value))
         return true;
-    } else{
-        qDebug() << "Cannot find gsettings, schema_id:" << schema_id
-                 << " path:" << path << " key:" << key;
-        if (settings)
-            delete settings;
 
-        return false;
-    }
+    qDebug() << "Cannot find gsettings, schema_id:" << schema_id
+             << " path:" << path << " key:" << key;
+    return false;
 }
 
 inline QPixmap renderSVG(const QString &path, const QSize &size, const qreal devicePixelRatio)
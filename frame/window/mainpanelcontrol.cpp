@@ -41,6 +41,7 @@
 #define PLUGIN_MAX_SIZE  40
 #define PLUGIN_MIN_SIZE  20
 #define DESKTOP_SIZE  10
+#define LAYOUT_INTERVAL 16
 
 DWIDGET_USE_NAMESPACE
 
@@ -66,7 +67,12 @@ MainPanelControl::MainPanelControl(QWidget *parent)
     , m_dislayMode(Efficient)
     , m_tray(nullptr)
     , m_trashItem(nullptr)
+    , m_layoutTimer(new QTimer(this))
 {
+    m_layoutTimer->setSingleShot(true);
+    m_layoutTimer->setInterval(LAYOUT_INTERVAL);
+    connect(m_layoutTimer, &QTimer::timeout, this, &MainPanelControl::updateDockIconSize);
+
     initUI();
     updateMainPanelLayout();
     setAcceptDrops(true);
@@ -971,8 +977,38 @@ void MainPanelControl::paintEvent(QPaintEvent *event)
 
 /**重新计算任务栏上应用图标、插件图标的大小，并设置
  * @brief MainPanelControl::resizeDockIcon
+ * @note 拖拽调整任务栏大小时每次移动都会调用，这里只记录需要重新计算，每一帧最多计算一次
  */
 void MainPanelControl::resizeDockIcon()
+{
+    if (!m_layoutTimer->isActive())
+        m_layoutTimer->start();
+}
+
+/**
+ * @brief MainPanelControl::pluginLayoutInfos
+ * @return 插件区域中的所有插件及其sizeHint
+ */
+QList<MainPanelControl::PluginLayoutInfo> MainPanelControl::pluginLayoutInfos() const
+{
+    QList<PluginLayoutInfo> infos;
+
+    // 因为日期时间大小和其他插件大小有异，为了设置边距，在各插件中增加了一层布局
+    // 因此需要通过多一层布局来获取各插件
+    for (int i = 0; i < m_pluginLayout->count(); ++ i) {
+        QLayout *layout = m_pluginLayout->itemAt(i)->layout();
+        if (!layout || !layout->itemAt(0))
+            continue;
+
+        PluginsItem *item = static_cast<PluginsItem *>(layout->itemAt(0)->widget());
+        if (item)
+            infos << PluginLayoutInfo { layout, item, item->sizeHint() };
+    }
+
+    return infos;
+}
+
+void MainPanelControl::updateDockIconSize()
 {
     // 总宽度
     int totalLength = ((m_position == Position::Top) || (m_position == Position::Bottom)) ? width() : height();
@@ -988,31 +1024,23 @@ void MainPanelControl::resizeDockIcon()
     // 减去显示桌面图标宽度
     totalLength -= ((m_position == Position::Top) || (m_position == Position::Bottom)) ? m_desktopWidget->width() : m_desktopWidget->height();
 
-    int pluginItemCount = 0;
     int calcPluginItemCount = 0;
 
-    // 因为日期时间大小和其他插件大小有异，为了设置边距，在各插件中增加了一层布局
-    // 因此需要通过多一层布局来获取各插件
-    for (int i = 0; i < m_pluginLayout->count(); ++ i) {
-        QLayout *layout = m_pluginLayout->itemAt(i)->layout();
-        if (layout) {
-            PluginsItem *w = static_cast<PluginsItem *>(layout->itemAt(0)->widget());
-            if (w) {
-                // 如果插件大小由自己决定,则不参与计算需要减去其宽度,其他插件则需要参与计算并计数
-                if ((m_position == Position::Top || m_position == Position::Bottom) && (w->sizeHint().height() != -1)) {
-                    totalLength -= w->width();
-                } else if ((m_position == Position::Top || m_position == Position::Bottom) && (w->sizeHint().width() != -1)) {
-                    totalLength -= w->height();
-                } else {
-                    calcPluginItemCount ++;
-                }
-
-                // 所有插件个数,用于计算插件之间的间隔之和
-                pluginItemCount ++;
-            }
+    const QList<PluginLayoutInfo> plugins = pluginLayoutInfos();
+    for (const PluginLayoutInfo &info : plugins) {
+        // 如果插件大小由自己决定,则不参与计算需要减去其宽度,其他插件则需要参与计算并计数
+        if ((m_position == Position::Top || m_position == Position::Bottom) && (info.sizeHint.height() != -1)) {
+            totalLength -= info.item->width();
+        } else if ((m_position == Position::Top || m_position == Position::Bottom) && (info.sizeHint.width() != -1)) {
+            totalLength -= info.item->height();
+        } else {
+            calcPluginItemCount ++;
         }
     }
 
+    // 所有插件个数,用于计算插件之间的间隔之和
+    const int pluginItemCount = plugins.size();
+
     // 减去插件间隔大小, 只有一个插件或没有插件都是间隔20,2个或以上每多一个插件多间隔10
     if (pluginItemCount > 1)
        totalLength -= (pluginItemCount + 1) * 10;
@@ -1057,77 +1085,75 @@ void MainPanelControl::resizeDockIcon()
     // icon宽度 = (总宽度-余数)/icon个数
     iconSize = (totalLength - yu) / iconCount;
 
+    // 所有的大小都设置完成后再统一刷新界面
+    setUpdatesEnabled(false);
+
     if ((m_position == Position::Top) || (m_position == Position::Bottom)) {
         if (iconSize >= height()) {
-            calcuDockIconSize(height(), height(), tray_item_size);
+            calcuDockIconSize(height(), height(), tray_item_size, plugins);
         } else {
-            calcuDockIconSize(iconSize, height(), tray_item_size);
+            calcuDockIconSize(iconSize, height(), tray_item_size, plugins);
         }
     } else {
         if (iconSize >= width()) {
-            calcuDockIconSize(width(), width(), tray_item_size);
+            calcuDockIconSize(width(), width(), tray_item_size, plugins);
         } else {
-            calcuDockIconSize(width(), iconSize, tray_item_size);
+            calcuDockIconSize(width(), iconSize, tray_item_size, plugins);
         }
     }
+
+    setUpdatesEnabled(true);
 }
 
-void MainPanelControl::calcuDockIconSize(int w, int h, int traySize)
+/**
+ * @brief setFixedSizeIfChanged 大小没有变化时不调用setFixedSize，避免重复触发布局计算
+ */
+static void setFixedSizeIfChanged(QWidget *widget, const QSize &size)
+{
+    if (widget->minimumSize() != size || widget->maximumSize() != size)
+        widget->setFixedSize(size);
+}
+
+void MainPanelControl::calcuDockIconSize(int w, int h, int traySize, const QList<PluginLayoutInfo> &plugins)
 {
     int appItemSize = qMin(w, h);
 
     for (int i = 0; i < m_fixedAreaLayout->count(); ++i) {
-        m_fixedAreaLayout->itemAt(i)->widget()->setFixedSize(appItemSize, appItemSize);
+        setFixedSizeIfChanged(m_fixedAreaLayout->itemAt(i)->widget(), QSize(appItemSize, appItemSize));
     }
 
     if (m_position == Dock::Position::Top || m_position == Dock::Position::Bottom) {
-        m_fixedSpliter->setFixedSize(SPLITER_SIZE, int(w * 0.6));
-        m_appSpliter->setFixedSize(SPLITER_SIZE, int(w * 0.6));
-        m_traySpliter->setFixedSize(SPLITER_SIZE, int(w * 0.5));
+        setFixedSizeIfChanged(m_fixedSpliter, QSize(SPLITER_SIZE, int(w * 0.6)));
+        setFixedSizeIfChanged(m_appSpliter, QSize(SPLITER_SIZE, int(w * 0.6)));
+        setFixedSizeIfChanged(m_traySpliter, QSize(SPLITER_SIZE, int(w * 0.5)));
     } else {
-        m_fixedSpliter->setFixedSize(int(h * 0.6), SPLITER_SIZE);
-        m_appSpliter->setFixedSize(int(h * 0.6), SPLITER_SIZE);
-        m_traySpliter->setFixedSize(int(h * 0.5), SPLITER_SIZE);
+        setFixedSizeIfChanged(m_fixedSpliter, QSize(int(h * 0.6), SPLITER_SIZE));
+        setFixedSizeIfChanged(m_appSpliter, QSize(int(h * 0.6), SPLITER_SIZE));
+        setFixedSizeIfChanged(m_traySpliter, QSize(int(h * 0.5), SPLITER_SIZE));
     }
 
     for (int i = 0; i < m_appAreaSonLayout->count(); ++i) {
-        m_appAreaSonLayout->itemAt(i)->widget()->setFixedSize(appItemSize, appItemSize);
+        setFixedSizeIfChanged(m_appAreaSonLayout->itemAt(i)->widget(), QSize(appItemSize, appItemSize));
     }
 
-    if (m_tray) {
+    if (m_tray && m_tray->centralWidget()->property("iconSize").toInt() != traySize) {
         m_tray->centralWidget()->setProperty("iconSize", traySize);
     }
 
-    //因为日期时间大小和其他插件大小有异，为了设置边距，在各插件中增加了一层布局
-    //因此需要通过多一层布局来获取各插件
-    if ((m_position == Position::Top) || (m_position == Position::Bottom)) {
-        // 三方插件
-        for (int i = 0; i < m_pluginLayout->count(); ++ i) {
-            QLayout *layout = m_pluginLayout->itemAt(i)->layout();
-            if (layout && layout->itemAt(0)) {
-                PluginsItem *pItem = static_cast<PluginsItem *>(layout->itemAt(0)->widget());
-                if (pItem) {
-                    if (pItem->sizeHint().height() == -1) {
-                        pItem->setFixedSize(traySize, traySize);
-                    } else if (pItem->sizeHint().height() > height()) {
-                        pItem->resize(pItem->width(), height());
-                    }
-                }
+    // 三方插件
+    for (const PluginLayoutInfo &info : plugins) {
+        PluginsItem *pItem = info.item;
+        if ((m_position == Position::Top) || (m_position == Position::Bottom)) {
+            if (info.sizeHint.height() == -1) {
+                setFixedSizeIfChanged(pItem, QSize(traySize, traySize));
+            } else if (info.sizeHint.height() > height()) {
+                pItem->resize(pItem->width(), height());
             }
-        }
-    } else {
-        // 三方插件
-        for (int i = 0; i < m_pluginLayout->count(); ++ i) {
-            QLayout *layout =  m_pluginLayout->itemAt(i)->layout();
-            if (layout) {
-                PluginsItem *pItem = static_cast<PluginsItem *>(layout->itemAt(0)->widget());
-                if (pItem) {
-                    if (pItem->sizeHint().width() == -1) {
-                        pItem->setFixedSize(traySize, traySize);
-                    } else if (pItem->sizeHint().width() > width()) {
-                        pItem->resize(width(), pItem->height());
-                    }
-                }
+        } else {
+            if (info.sizeHint.width() == -1) {
+                setFixedSizeIfChanged(pItem, QSize(traySize, traySize));
+            } else if (info.sizeHint.width() > width()) {
+                pItem->resize(width(), pItem->height());
             }
         }
     }
@@ -1152,14 +1178,9 @@ void MainPanelControl::calcuDockIconSize(int w, int h, int traySize)
 
     //因为日期时间插件或第三方插件声明自定义大小
     //而不对自定义大小插件设置边距
-    for (int i = 0; i < m_pluginLayout->count(); ++ i) {
-        QLayout *layout = m_pluginLayout->itemAt(i)->layout();
-        if (layout && layout->itemAt(0)) {
-            PluginsItem *pItem = static_cast<PluginsItem *>(layout->itemAt(0)->widget());
-
-            if (pItem && pItem->pluginSizePolicy() != PluginsItemInterface::Custom) {
-                layout->setContentsMargins(trayLeftAndRightMargin, trayTopAndBottomMargin, trayLeftAndRightMargin, trayTopAndBottomMargin);
-            }
+    for (const PluginLayoutInfo &info : plugins) {
+        if (info.item->pluginSizePolicy() != PluginsItemInterface::Custom) {
+            info.layout->setContentsMargins(trayLeftAndRightMargin, trayTopAndBottomMargin, trayLeftAndRightMargin, trayTopAndBottomMargin);
         }
     }
 }
@@ -15,6 +15,8 @@ using namespace Dock;
 
 class QBoxLayout;
 class QLabel;
+class QTimer;
+class QLayout;
 class TrayPluginItem;
 class PluginsItem;
 class DockItem;
@@ -62,7 +64,16 @@ private:
     DockItem *dropTargetItem(DockItem *sourceItem, QPoint point);
     void moveItem(DockItem *sourceItem, DockItem *targetItem);
     void handleDragMove(QDragMoveEvent *e, bool isFilter);
-    void calcuDockIconSize(int w, int h, int traySize);
+
+    // 一次布局计算中用到的插件信息，sizeHint只获取一次
+    struct PluginLayoutInfo {
+        QLayout *layout;
+        PluginsItem *item;
+        QSize sizeHint;
+    };
+    QList<PluginLayoutInfo> pluginLayoutInfos() const;
+    void updateDockIconSize();
+    void calcuDockIconSize(int w, int h, int traySize, const QList<PluginLayoutInfo> &plugins);
     void resizeDesktopWidget();
     bool checkNeedShowDesktop();
     bool appIsOnDock(const QString &appDesktop);
@@ -107,6 +118,7 @@ private:
     int m_dragIndex = -1;   // 记录应用区域被拖拽图标的位置
 
     PluginsItem *m_trashItem;       // 垃圾箱插件（需要特殊处理一下）
+    QTimer *m_layoutTimer;          // 合并同一帧内的多次图标大小计算
 };
 
 #endif // MAINPANELCONTROL_H
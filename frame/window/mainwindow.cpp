@@ -6,6 +6,8 @@
 #include "mainpanelcontrol.h"
 #include "dockitemmanager.h"
 #include "menuworker.h"
+#include "icondiskcache.h"
+#include "startuptracer.h"
 
 #include <DStyle>
 #include <DPlatformWindowHandle>
@@ -17,6 +19,7 @@
 #include <QEvent>
 #include <QResizeEvent>
 #include <QScreen>
+#include <QDateTime>
 #include <QGuiApplication>
 #include <QX11Info>
 #include <QtConcurrent>
@@ -136,6 +139,8 @@ void MainWindow::launch()
     if (!qApp->property("CANSHOW").toBool())
         return;
 
+    TraceSpan span("MainWindow::launch");
+
     m_launched = true;
     m_multiScreenWorker->initShow();
     m_shadowMaskOptimizeTimer->start();
@@ -255,6 +260,20 @@ void MainWindow::resizeEvent(QResizeEvent *event)
     return DBlurEffectWidget::resizeEvent(event);
 }
 
+void MainWindow::paintEvent(QPaintEvent *event)
+{
+    DBlurEffectWidget::paintEvent(event);
+
+    // 记录启动到第一次绘制的耗时，tests/startup-benchmark.sh通过此日志比较图标缓存冷启动和热启动的差异
+    static bool firstPaint = true;
+    if (firstPaint) {
+        firstPaint = false;
+        StartupTracer::instance()->addEvent("MainWindow::firstPaint", QString(), "startup", 0, StartupTracer::instance()->now());
+        qInfo() << "time to first paint:" << QDateTime::currentMSecsSinceEpoch() - qApp->property("START_TIME").toLongLong() << "ms,"
+                << "icon cache hits:" << IconDiskCache::instance()->hits() << "misses:" << IconDiskCache::instance()->misses();
+    }
+}
+
 void MainWindow::dragEnterEvent(QDragEnterEvent *e)
 {
     QWidget::dragEnterEvent(e);
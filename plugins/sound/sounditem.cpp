@@ -32,6 +32,7 @@ SoundItem::SoundItem(QWidget *parent)
     , m_tipsLabel(new TipsWidget(this))
     , m_applet(new SoundApplet)
     , m_sinkInter(nullptr)
+    , m_iconResizePolicy(this, [ this ] { refreshIcon(); })
 {
     m_tipsLabel->setAccessibleName("soundtips");
     m_tipsLabel->setVisible(false);
@@ -133,7 +134,8 @@ void SoundItem::resizeEvent(QResizeEvent *e)
         setMaximumWidth(QWIDGETSIZE_MAX);
     }
 
-    refreshIcon();
+    // 拖拽调整任务栏大小时等大小稳定后再刷新
+    m_iconResizePolicy.requestRefresh();
 }
 
 void SoundItem::wheelEvent(QWheelEvent *e)
@@ -203,6 +205,14 @@ void SoundItem::refreshIcon()
     if (height() <= PLUGIN_BACKGROUND_MIN_SIZE && DGuiApplicationHelper::instance()->themeType() == DGuiApplicationHelper::LightType)
         iconString.append(PLUGIN_MIN_ICON_NAME);
 
+    m_iconResizePolicy.cancel();
+
+    // 图标大小固定，只有图标名、缩放比例或主题变化时才需要重新渲染svg
+    const QString iconKey = QString("%1@%2#%3").arg(iconString).arg(ratio).arg(DGuiApplicationHelper::instance()->themeType());
+    if (iconKey == m_iconKey && !m_iconPixmap.isNull())
+        return;
+
+    m_iconKey = iconKey;
     m_iconPixmap = ImageUtil::loadSvg(iconString, ":/", iconSize, ratio);
 
     update();
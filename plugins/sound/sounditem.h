@@ -6,6 +6,7 @@
 #define SOUNDITEM_H
 
 #include "soundapplet.h"
+#include "../frame/util/iconresizepolicy.h"
 #include <com_deepin_daemon_audio_sink.h>
 
 #include <QWidget>
@@ -51,6 +52,8 @@ private:
     QScopedPointer<SoundApplet> m_applet;
     DBusSink *m_sinkInter;
     QPixmap m_iconPixmap;
+    QString m_iconKey;                      // 当前图标对应的图标名、缩放比例和主题，没有变化时不重新渲染
+    IconResizePolicy m_iconResizePolicy;
 };
 
 #endif // SOUNDITEM_H
@@ -7,15 +7,15 @@
 #include <QLabel>
 #include <QDBusConnection>
 #include <QJsonObject>
-#include <QDBusInterface>
-#include <QDBusReply>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusVariant>
 #include <QDebug>
 #include <QApplication>
 #include <QJsonDocument>
 #include <QFile>
 #include <QTimer>
 #include <QDBusMessage>
-#include <thread>
 
 class IndicatorTrayPrivate
 {
@@ -42,13 +42,19 @@ public:
         auto isSystemBus = dataConfig.value("system_dbus").toBool(false);
         auto bus = isSystemBus ? QDBusConnection::systemBus() : QDBusConnection::sessionBus();
 
-        QDBusInterface interface(dbusService, dbusPath, dbusInterface, bus, q);
-
+        // 不使用QDBusInterface，避免同步的Introspect调用，所有请求异步发送
         if (dataConfig.contains("dbus_method")) {
             QString methodName = dataConfig.value("dbus_method").toString();
             auto ratio = qApp->devicePixelRatio();
-            QDBusReply<QByteArray> reply = interface.call(methodName.toStdString().c_str(), ratio);
-            callback(reply.value());
+            QDBusMessage msg = QDBusMessage::createMethodCall(dbusService, dbusPath, dbusInterface, methodName);
+            msg << ratio;
+
+            QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(bus.asyncCall(msg), q);
+            q->connect(watcher, &QDBusPendingCallWatcher::finished, q, [ = ] {
+                watcher->deleteLater();
+                QDBusPendingReply<QByteArray> reply = *watcher;
+                callback(reply.isError() ? QByteArray() : reply.value());
+            });
         }
 
         if (dataConfig.contains("dbus_properties")) {
@@ -74,7 +80,15 @@ public:
                                                   q,
                                                   propertyChangedSlot);
 
-            callback(interface.property(propertyNameCStr.c_str()));
+            QDBusMessage msg = QDBusMessage::createMethodCall(dbusService, dbusPath, "org.freedesktop.DBus.Properties", "Get");
+            msg << dbusInterface << propertyName;
+
+            QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(bus.asyncCall(msg), q);
+            q->connect(watcher, &QDBusPendingCallWatcher::finished, q, [ = ] {
+                watcher->deleteLater();
+                QDBusPendingReply<QDBusVariant> reply = *watcher;
+                callback(reply.isError() ? QVariant() : reply.value().variant());
+            });
         }
     }
 
@@ -181,25 +195,28 @@ void IndicatorTrayPrivate::initDBus(const QString &indicatorName)
         const QJsonObject action = config.value("action").toObject();
         if (!action.isEmpty() && indicatorTrayWidget)
             q->connect(indicatorTrayWidget, &IndicatorTrayWidget::clicked, q, [ = ](uint8_t button_index, int x, int y) {
-                std::thread t([=]() -> void {
-                    auto triggerConfig = action.value("trigger").toObject();
-                    auto dbusService = triggerConfig.value("dbus_service").toString();
-                    auto dbusPath = triggerConfig.value("dbus_path").toString();
-                    auto dbusInterface = triggerConfig.value("dbus_interface").toString();
-                    auto methodName = triggerConfig.value("dbus_method").toString();
-                    auto isSystemBus = triggerConfig.value("system_dbus").toBool(false);
-                    auto bus = isSystemBus ? QDBusConnection::systemBus() : QDBusConnection::sessionBus();
-
-                    QDBusInterface interface(dbusService, dbusPath, dbusInterface, bus);
-                    QDBusReply<void> reply = interface.call(methodName, button_index, x, y);
-                    if (!reply.isValid()) {
-                        qDebug() << interface.call(methodName);
-                    }
-                    else {
-                        qDebug() << reply.error();
-                    }
+                auto triggerConfig = action.value("trigger").toObject();
+                auto dbusService = triggerConfig.value("dbus_service").toString();
+                auto dbusPath = triggerConfig.value("dbus_path").toString();
+                auto dbusInterface = triggerConfig.value("dbus_interface").toString();
+                auto methodName = triggerConfig.value("dbus_method").toString();
+                auto isSystemBus = triggerConfig.value("system_dbus").toBool(false);
+                auto bus = isSystemBus ? QDBusConnection::systemBus() : QDBusConnection::sessionBus();
+
+                // 异步调用，不再为每次点击创建线程
+                QDBusMessage msg = QDBusMessage::createMethodCall(dbusService, dbusPath, dbusInterface, methodName);
+                msg << int(button_index) << x << y;
+
+                QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(bus.asyncCall(msg), q);
+                q->connect(watcher, &QDBusPendingCallWatcher::finished, q, [ = ] {
+                    watcher->deleteLater();
+                    if (!watcher->isError())
+                        return;
+
+                    // 方法不接受参数时，不带参数再调用一次
+                    qDebug() << watcher->error();
+                    bus.asyncCall(QDBusMessage::createMethodCall(dbusService, dbusPath, dbusInterface, methodName));
                 });
-                t.detach();
             });
     });
 }
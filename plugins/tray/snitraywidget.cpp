@@ -4,36 +4,112 @@
 
 #include "snitraywidget.h"
 #include "util/themeappicon.h"
+#include "util/themeiconresolver.h"
+#include "util/imageutil.h"
+#include "util/iconthemepathindex.h"
 #include "../../widgets/tipswidget.h"
 
 #include <dbusmenu-qt5/dbusmenuimporter.h>
 
 #include <DGuiApplicationHelper>
+#include <DApplication>
 
 #include <QPainter>
+#include <QIcon>
 #include <QApplication>
 #include <QDBusPendingCall>
+#include <QDBusPendingCallWatcher>
+#include <QDBusMessage>
 #include <QtConcurrent>
 #include <QFuture>
+#include <QFutureWatcher>
+#include <QCache>
+#include <QDataStream>
 
 #include <xcb/xproto.h>
 
 DGUI_USE_NAMESPACE
+DWIDGET_USE_NAMESPACE
 
 #define IconSize 20
 
+// 属性合并获取的间隔，频繁发送信号的程序会逐步退避到上限
+#define FetchIntervalMin 16
+#define FetchIntervalMax 2000
+
 const QStringList ItemCategoryList {"ApplicationStatus", "Communications", "SystemServices", "Hardware"};
 const QStringList ItemStatusList {"Passive", "Active", "NeedsAttention"};
+/**
+ * @brief The SNIImageKey struct
+ * 以图片内容作为缓存的键值，动画图标中相同的帧不需要重新转换和缩放
+ */
+struct SNIImageKey {
+    QByteArray pixels;
+    int width;
+    int height;
+    int size;
+
+    bool operator==(const SNIImageKey &other) const
+    {
+        return width == other.width && height == other.height && size == other.size && pixels == other.pixels;
+    }
+};
+
+static inline uint qHash(const SNIImageKey &key, uint seed = 0)
+{
+    return qHash(key.pixels, seed) ^ uint(key.width << 16 | key.height) ^ uint(key.size);
+}
+
+// 所有托盘共用，按像素字节数计算，最多保留约4M
+static QCache<SNIImageKey, QPixmap> SNIPixmapCache(4 * 1024 * 1024);
+
+/**
+ * @brief bestFitImage 选择不小于目标大小的最小图片，都比目标小时选择最大的图片
+ */
+static const DBusImage *bestFitImage(const DBusImageList &imageList, int size)
+{
+    const DBusImage *best = nullptr;
+    for (const DBusImage &image : imageList) {
+        if (image.width <= 0 || image.height <= 0 || image.pixels.size() < image.width * image.height * 4)
+            continue;
+
+        if (!best) {
+            best = &image;
+            continue;
+        }
+
+        const bool fit = qMin(image.width, image.height) >= size;
+        const bool bestFit = qMin(best->width, best->height) >= size;
+        if (fit != bestFit) {
+            if (fit)
+                best = &image;
+            continue;
+        }
+
+        // 都足够大时选较小的，缩放的开销更小；都不够大时选较大的，显示更清晰
+        if ((fit && image.width * image.height < best->width * best->height)
+                || (!fit && image.width * image.height > best->width * best->height))
+            best = &image;
+    }
+
+    return best;
+}
+
 QPointer<DockPopupWindow> SNITrayWidget::PopupWindow = nullptr;
 Dock::Position SNITrayWidget::DockPosition = Dock::Position::Top;
 using namespace Dock;
-SNITrayWidget::SNITrayWidget(const QString &sniServicePath, QWidget *parent)
+SNITrayWidget::SNITrayWidget(const QString &sniServicePath, uint ownerPID, QWidget *parent)
     : AbstractTrayWidget(parent),
       m_dbusMenuImporter(nullptr),
       m_menu(nullptr),
       m_updateIconTimer(new QTimer(this))
     , m_updateOverlayIconTimer(new QTimer(this))
     , m_updateAttentionIconTimer(new QTimer(this))
+    , m_fetchTimer(new QTimer(this))
+    , m_pendingGroups(0)
+    , m_signalsSinceFetch(0)
+    , m_fetching(false)
+    , m_ready(false)
     , m_sniServicePath(sniServicePath)
     , m_popupTipsDelayTimer(new QTimer(this))
     , m_handleMouseReleaseTimer(new QTimer(this))
@@ -69,8 +145,10 @@ SNITrayWidget::SNITrayWidget(const QString &sniServicePath, QWidget *parent)
     m_dbusService = pair.first;
     m_dbusPath = pair.second;
 
-    QDBusConnection conn = QDBusConnection::sessionBus();
-    setOwnerPID(conn.interface()->servicePid(m_dbusService));
+    // 没有传入时才同步获取
+    if (!ownerPID)
+        ownerPID = QDBusConnection::sessionBus().interface()->servicePid(m_dbusService);
+    setOwnerPID(ownerPID);
 
     m_sniInter = new StatusNotifierItem(m_dbusService, m_dbusPath, QDBusConnection::sessionBus(), this);
     m_sniInter->setSync(false);
@@ -85,11 +163,34 @@ SNITrayWidget::SNITrayWidget(const QString &sniServicePath, QWidget *parent)
     m_updateOverlayIconTimer->setSingleShot(true);
     m_updateAttentionIconTimer->setInterval(1000);
     m_updateAttentionIconTimer->setSingleShot(true);
+    m_fetchTimer->setInterval(FetchIntervalMin);
+    m_fetchTimer->setSingleShot(true);
+    m_fetchStatistics.interval = FetchIntervalMin;
 
     connect(DGuiApplicationHelper::instance(), &DGuiApplicationHelper::themeTypeChanged, this, &SNITrayWidget::refreshIcon);
+    // 图标主题变化后缓存的帧不再有效，需要重新从主题中加载
+    if (DApplication *app = qobject_cast<DApplication *>(qApp)) {
+        connect(app, &DApplication::iconThemeChanged, this, [ = ] {
+            m_frameCache.clear();
+            if (m_sniStatus == "NeedsAttention" && (!m_sniAttentionIconName.isEmpty() || !m_sniAttentionIconPixmap.isEmpty()))
+                refreshAttentionIcon();
+            else
+                refreshIcon();
+            refreshOverlayIcon();
+        });
+    }
     connect(m_updateIconTimer, &QTimer::timeout, this, &SNITrayWidget::refreshIcon);
     connect(m_updateOverlayIconTimer, &QTimer::timeout, this, &SNITrayWidget::refreshOverlayIcon);
     connect(m_updateAttentionIconTimer, &QTimer::timeout, this, &SNITrayWidget::refreshAttentionIcon);
+    connect(m_fetchTimer, &QTimer::timeout, this, &SNITrayWidget::fetchPropertys);
+    connect(IconThemePathIndex::instance(), &IconThemePathIndex::indexChanged, this, [ = ](const QString &themePath) {
+        if (themePath != m_sniIconThemePath)
+            return;
+
+        m_updateIconTimer->start();
+        if (!m_sniOverlayIconName.isEmpty())
+            m_updateOverlayIconTimer->start();
+    });
 
     // SNI property change
     // thses signals of properties may not be emit automatically!!
@@ -109,31 +210,11 @@ SNITrayWidget::SNITrayWidget(const QString &sniServicePath, QWidget *parent)
     connect(m_sniInter, &StatusNotifierItem::StatusChanged, this, &SNITrayWidget::onSNIStatusChanged);
 
     // the following signals can be emit automatically
-    // need refresh cached properties in these slots
-    connect(m_sniInter, &StatusNotifierItem::NewIcon, [ = ] {
-        m_sniIconName = m_sniInter->iconName();
-        m_sniIconPixmap = m_sniInter->iconPixmap();
-        m_sniIconThemePath = m_sniInter->iconThemePath();
-
-        m_updateIconTimer->start();
-    });
-    connect(m_sniInter, &StatusNotifierItem::NewOverlayIcon, [ = ] {
-        m_sniOverlayIconName = m_sniInter->overlayIconName();
-        m_sniOverlayIconPixmap = m_sniInter->overlayIconPixmap();
-        m_sniIconThemePath = m_sniInter->iconThemePath();
-
-        m_updateOverlayIconTimer->start();
-    });
-    connect(m_sniInter, &StatusNotifierItem::NewAttentionIcon, [ = ] {
-        m_sniAttentionIconName = m_sniInter->attentionIconName();
-        m_sniAttentionIconPixmap = m_sniInter->attentionIconPixmap();
-        m_sniIconThemePath = m_sniInter->iconThemePath();
-
-        m_updateAttentionIconTimer->start();
-    });
-    connect(m_sniInter, &StatusNotifierItem::NewStatus, [ = ] {
-        onSNIStatusChanged(m_sniInter->status());
-    });
+    // 这些信号只表示属性发生了变化，在一个间隔内合并后统一通过 GetAll 获取
+    connect(m_sniInter, &StatusNotifierItem::NewIcon, this, [ = ] { scheduleFetch(IconGroup); });
+    connect(m_sniInter, &StatusNotifierItem::NewOverlayIcon, this, [ = ] { scheduleFetch(OverlayIconGroup); });
+    connect(m_sniInter, &StatusNotifierItem::NewAttentionIcon, this, [ = ] { scheduleFetch(AttentionIconGroup); });
+    connect(m_sniInter, &StatusNotifierItem::NewStatus, this, [ = ] { scheduleFetch(StatusGroup); });
 
     initSNIPropertys();
 }
@@ -234,22 +315,112 @@ uint SNITrayWidget::servicePID(const QString &servicePath)
 
 void SNITrayWidget::initSNIPropertys()
 {
-    m_sniAttentionIconName = m_sniInter->attentionIconName();
-    m_sniAttentionIconPixmap = m_sniInter->attentionIconPixmap();
-    m_sniAttentionMovieName = m_sniInter->attentionMovieName();
-    m_sniCategory = m_sniInter->category();
-    m_sniIconName = m_sniInter->iconName();
-    m_sniIconPixmap = m_sniInter->iconPixmap();
-    m_sniIconThemePath = m_sniInter->iconThemePath();
-    m_sniId = m_sniInter->id();
-    m_sniMenuPath = m_sniInter->menu();
-    m_sniOverlayIconName = m_sniInter->overlayIconName();
-    m_sniOverlayIconPixmap = m_sniInter->overlayIconPixmap();
-    m_sniStatus = m_sniInter->status();
+    // 启动时立即获取一次全部属性
+    m_pendingGroups |= IconGroup | StatusGroup;
+    fetchPropertys();
+}
 
-    m_updateIconTimer->start();
-//    m_updateOverlayIconTimer->start();
-//    m_updateAttentionIconTimer->start();
+/**
+ * @brief SNITrayWidget::scheduleFetch 记录需要刷新的属性组，在当前间隔结束后合并为一次 GetAll 调用
+ * @param groups 属性组
+ */
+void SNITrayWidget::scheduleFetch(int groups)
+{
+    m_pendingGroups |= groups;
+    ++m_signalsSinceFetch;
+    ++m_fetchStatistics.signalCount;
+
+    // 请求返回后会再次检查是否有等待中的属性组
+    if (!m_fetching && !m_fetchTimer->isActive())
+        m_fetchTimer->start();
+}
+
+void SNITrayWidget::fetchPropertys()
+{
+    if (m_fetching || !m_pendingGroups)
+        return;
+
+    // 一个间隔内合并了多个信号说明程序在频繁刷新，加倍间隔，否则逐步恢复
+    int interval = m_fetchTimer->interval();
+    if (m_signalsSinceFetch > 1) {
+        interval = qMin(interval * 2, FetchIntervalMax);
+        if (interval == FetchIntervalMax) {
+            if (m_fetchStatistics.throttledCount++ == 0)
+                qWarning() << "SNI item emits too many signals, throttled:" << m_dbusService << m_sniId;
+        }
+    } else {
+        interval = qMax(interval / 2, FetchIntervalMin);
+    }
+    m_fetchTimer->setInterval(interval);
+    m_fetchStatistics.interval = interval;
+    m_signalsSinceFetch = 0;
+
+    const int groups = m_pendingGroups;
+    m_pendingGroups = 0;
+    m_fetching = true;
+    ++m_fetchStatistics.fetchCount;
+
+    QDBusMessage msg = QDBusMessage::createMethodCall(m_dbusService, m_dbusPath, "org.freedesktop.DBus.Properties", "GetAll");
+    msg << QString("org.kde.StatusNotifierItem");
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(msg), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [ = ] {
+        watcher->deleteLater();
+        m_fetching = false;
+
+        QDBusPendingReply<QVariantMap> reply = *watcher;
+        if (reply.isError()) {
+            qDebug() << "SNI get propertys failed:" << m_dbusService << m_dbusPath << reply.error().message();
+        } else {
+            applyPropertys(reply.value());
+
+            if (groups & IconGroup)
+                refreshIcon();
+            if (groups & OverlayIconGroup)
+                refreshOverlayIcon();
+            if (groups & AttentionIconGroup)
+                refreshAttentionIcon();
+        }
+
+        // 请求期间又收到了信号
+        if (m_pendingGroups && !m_fetchTimer->isActive())
+            m_fetchTimer->start();
+
+        // 获取失败时按照默认的状态添加，和之前同步获取的行为一致
+        if (!m_ready) {
+            m_ready = true;
+            Q_EMIT ready();
+        }
+    });
+}
+
+void SNITrayWidget::applyPropertys(const QVariantMap &propertys)
+{
+    auto stringValue = [ & ](const char *name, QString &value) {
+        if (propertys.contains(name))
+            value = propertys.value(name).toString();
+    };
+    auto imageValue = [ & ](const char *name, DBusImageList &value) {
+        if (propertys.contains(name))
+            value = qdbus_cast<DBusImageList>(propertys.value(name));
+    };
+
+    stringValue("AttentionIconName", m_sniAttentionIconName);
+    imageValue("AttentionIconPixmap", m_sniAttentionIconPixmap);
+    stringValue("AttentionMovieName", m_sniAttentionMovieName);
+    stringValue("Category", m_sniCategory);
+    stringValue("IconName", m_sniIconName);
+    imageValue("IconPixmap", m_sniIconPixmap);
+    stringValue("IconThemePath", m_sniIconThemePath);
+    stringValue("Id", m_sniId);
+    stringValue("OverlayIconName", m_sniOverlayIconName);
+    imageValue("OverlayIconPixmap", m_sniOverlayIconPixmap);
+
+    if (propertys.contains("Menu"))
+        m_sniMenuPath = qdbus_cast<QDBusObjectPath>(propertys.value("Menu"));
+
+    if (propertys.contains("Status"))
+        onSNIStatusChanged(propertys.value("Status").toString());
 }
 
 void SNITrayWidget::initMenu()
@@ -418,8 +589,17 @@ void SNITrayWidget::onSNIStatusChanged(const QString &status)
         return;
     }
 
+    const QString previous = m_sniStatus;
     m_sniStatus = status;
 
+    // 进入或退出提醒状态时切换图标，两者都在帧缓存中
+    if (!previous.isEmpty() && (status == "NeedsAttention") != (previous == "NeedsAttention")) {
+        if (status == "NeedsAttention" && (!m_sniAttentionIconName.isEmpty() || !m_sniAttentionIconPixmap.isEmpty()))
+            refreshAttentionIcon();
+        else if (status != "NeedsAttention")
+            refreshIcon();
+    }
+
     Q_EMIT statusChanged(static_cast<SNITrayWidget::ItemStatus>(ItemStatusList.indexOf(status)));
 }
 
@@ -479,41 +659,46 @@ QPixmap SNITrayWidget::newIconPixmap(IconType iconType)
 
     const auto ratio = devicePixelRatioF();
     const int iconSizeScaled = IconSize * ratio;
+    const DBusImage *dbusImage = bestFitImage(dbusImageList, iconSizeScaled);
+    const QString &iconFile = IconThemePathIndex::instance()->lookup(iconThemePath, iconName, iconSizeScaled);
+
+    // 图标的来源不变时直接使用缓存的帧，提醒图标和普通图标之间切换时不需要重新解码
+    QByteArray frameKey;
+    QDataStream stream(&frameKey, QIODevice::WriteOnly);
+    stream << int(iconType) << iconName << iconFile << iconSizeScaled << int(DGuiApplicationHelper::instance()->themeType()) << QIcon::themeName();
+    if (dbusImage)
+        stream << dbusImage->width << dbusImage->height << qHash(dbusImage->pixels);
+    if (m_frameCache.find(frameKey, pixmap))
+        return pixmap;
+
+    bool cacheable = true;
     do {
         // load icon from sni dbus
-        if (!dbusImageList.isEmpty() && !dbusImageList.first().pixels.isEmpty()) {
-            for (DBusImage dbusImage : dbusImageList) {
-                char *image_data = dbusImage.pixels.data();
-
-                if (QSysInfo::ByteOrder == QSysInfo::LittleEndian) {
-                    for (int i = 0; i < dbusImage.pixels.size(); i += 4) {
-                        *(qint32 *)(image_data + i) = qFromBigEndian(*(qint32 *)(image_data + i));
-                    }
-                }
-
-                QImage image((const uchar *)dbusImage.pixels.constData(), dbusImage.width, dbusImage.height, QImage::Format_ARGB32);
-                pixmap = QPixmap::fromImage(image.scaled(iconSizeScaled, iconSizeScaled, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-                pixmap.setDevicePixelRatio(ratio);
-                if (!pixmap.isNull()) {
-                    break;
-                }
+        // 只转换最合适的一个尺寸
+        if (dbusImage) {
+            const SNIImageKey key {dbusImage->pixels, dbusImage->width, dbusImage->height, iconSizeScaled};
+            if (QPixmap *cached = SNIPixmapCache.object(key)) {
+                pixmap = *cached;
+            } else {
+                const QImage &image = ImageUtil::fromBigEndianARGB32(reinterpret_cast<const uchar *>(dbusImage->pixels.constData()),
+                                                                     dbusImage->width, dbusImage->height);
+                if (qMax(image.width(), image.height()) == iconSizeScaled)
+                    pixmap = QPixmap::fromImage(image);
+                else
+                    pixmap = QPixmap::fromImage(image.scaled(iconSizeScaled, iconSizeScaled, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+
+                if (!pixmap.isNull())
+                    SNIPixmapCache.insert(key, new QPixmap(pixmap), pixmap.width() * pixmap.height() * 4 + key.pixels.size());
             }
+            pixmap.setDevicePixelRatio(ratio);
         }
 
         // load icon from specified file
-        if (!iconThemePath.isEmpty() && !iconName.isEmpty()) {
-            QDirIterator it(iconThemePath, QDirIterator::Subdirectories);
-            while (it.hasNext()) {
-                it.next();
-                if (it.fileName().startsWith(iconName, Qt::CaseInsensitive)) {
-                    QImage image(it.filePath());
-                    pixmap = QPixmap::fromImage(image.scaled(iconSizeScaled, iconSizeScaled, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-                    pixmap.setDevicePixelRatio(ratio);
-                    if (!pixmap.isNull()) {
-                        break;
-                    }
-                }
-            }
+        // 图标目录的索引在后台建立，建立完成前先使用主题中的图标，完成后会重新刷新
+        if (!iconFile.isEmpty()) {
+            QImage image(iconFile);
+            pixmap = QPixmap::fromImage(image.scaled(iconSizeScaled, iconSizeScaled, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+            pixmap.setDevicePixelRatio(ratio);
             if (!pixmap.isNull()) {
                 break;
             }
@@ -524,7 +709,11 @@ QPixmap SNITrayWidget::newIconPixmap(IconType iconType)
         // so, it should be the last fallback
         if (!iconName.isEmpty()) {
             // ThemeAppIcon::getIcon 会处理高分屏缩放问题
-             ThemeAppIcon::getIcon(pixmap, iconName, IconSize);
+            // 获取失败时先显示默认图标，在后台线程中重新查找，找到后再刷新
+            if (!ThemeAppIcon::getIcon(pixmap, iconName, IconSize)) {
+                resolveIconAsync(iconType, iconName);
+                cacheable = false;
+            }
             if (!pixmap.isNull()) {
                 break;
             }
@@ -535,9 +724,61 @@ QPixmap SNITrayWidget::newIconPixmap(IconType iconType)
         }
     } while (false);
 
+    if (cacheable)
+        m_frameCache.insert(frameKey, pixmap);
+
     return pixmap;
 }
 
+void SNITrayWidget::resolveIconAsync(IconType iconType, const QString &iconName)
+{
+    // 每次刷新都会调用到这里，同一个图标同时只在后台查找一次
+    const QPair<int, QString> request(iconType, iconName);
+    if (m_resolvingIcons.contains(request))
+        return;
+
+    m_resolvingIcons.insert(request);
+
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [ = ] {
+        watcher->deleteLater();
+        m_resolvingIcons.remove(request);
+
+        QPixmap pixmap = QPixmap::fromImage(watcher->result());
+        if (pixmap.isNull())
+            return;
+
+        pixmap.setDevicePixelRatio(devicePixelRatioF());
+
+        // 查找期间图标可能已经被更新，丢弃过期的结果
+        switch (iconType) {
+        case Icon:
+            if (iconName != m_sniIconName)
+                return;
+            m_pixmap = pixmap;
+            break;
+        case OverlayIcon:
+            if (iconName != m_sniOverlayIconName)
+                return;
+            m_overlayPixmap = pixmap;
+            break;
+        case AttentionIcon:
+            // 查找期间已经退出提醒状态时不能覆盖普通图标
+            if (iconName != m_sniAttentionIconName || m_sniStatus != "NeedsAttention")
+                return;
+            m_pixmap = pixmap;
+            break;
+        default:
+            return;
+        }
+
+        update();
+        Q_EMIT iconChanged();
+    });
+
+    watcher->setFuture(ThemeIconResolver::instance()->resolveImage(iconName, int(IconSize * devicePixelRatioF())));
+}
+
 void SNITrayWidget::enterEvent(QEvent *event)
 {
     // 触屏不显示hover效果
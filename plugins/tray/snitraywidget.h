@@ -8,11 +8,13 @@
 #include "constants.h"
 #include "abstracttraywidget.h"
 #include "util/dockpopupwindow.h"
+#include "util/iconframecache.h"
 
 #include <org_kde_statusnotifieritem.h>
 
 #include <QMenu>
 #include <QDBusObjectPath>
+#include <QSet>
 DWIDGET_USE_NAMESPACE
 DGUI_USE_NAMESPACE
 class DBusMenuImporter;
@@ -34,15 +36,28 @@ public:
     enum ItemCategory {UnknownCategory = -1, ApplicationStatus, Communications, SystemServices, Hardware};
     enum ItemStatus {Passive, Active, NeedsAttention};
     enum IconType {UnknownIconType = -1, Icon, OverlayIcon, AttentionIcon, AttentionMovieIcon};
+    enum PropertyGroup {IconGroup = 0x1, OverlayIconGroup = 0x2, AttentionIconGroup = 0x4, StatusGroup = 0x8};
+
+    /**
+     * @brief The FetchStatistics struct
+     * 属性获取的统计信息，用于找出频繁发送信号的程序
+     */
+    struct FetchStatistics {
+        quint64 signalCount = 0;      // 收到的 New* 信号数
+        quint64 fetchCount = 0;       // 实际发出的 GetAll 调用数
+        quint64 throttledCount = 0;   // 间隔退避到上限的次数
+        int interval = 0;             // 当前的合并间隔(毫秒)
+    };
 
 public:
-    SNITrayWidget(const QString &sniServicePath, QWidget *parent = Q_NULLPTR);
+    SNITrayWidget(const QString &sniServicePath, uint ownerPID = 0, QWidget *parent = Q_NULLPTR);
 
     QString itemKeyForConfig() override;
     void updateIcon() override;
     void sendClick(uint8_t mouseButton, int x, int y) override;
 
     bool isValid() override;
+    bool isReady() const { return m_ready; }
     SNITrayWidget::ItemStatus status();
     SNITrayWidget::ItemCategory category();
 
@@ -58,11 +73,16 @@ public:
 
     static void setDockPostion(const Dock::Position pos) { DockPosition = pos; }
 
+    const FetchStatistics &fetchStatistics() const { return m_fetchStatistics; }
+
 Q_SIGNALS:
     void statusChanged(SNITrayWidget::ItemStatus status);
+    // 第一次获取属性完成，此时状态和Id才是准确的
+    void ready();
 
 private Q_SLOTS:
     void initSNIPropertys();
+    void fetchPropertys();
     void initMenu();
     void refreshIcon();
     void refreshOverlayIcon();
@@ -92,6 +112,9 @@ private Q_SLOTS:
 private:
     void paintEvent(QPaintEvent *e) override;
     QPixmap newIconPixmap(IconType iconType);
+    void resolveIconAsync(IconType iconType, const QString &iconName);
+    void scheduleFetch(int groups);
+    void applyPropertys(const QVariantMap &propertys);
     void setMouseData(QMouseEvent *e);
     void handleMouseRelease();
 
@@ -104,6 +127,14 @@ private:
     QTimer *m_updateIconTimer;
     QTimer *m_updateOverlayIconTimer;
     QTimer *m_updateAttentionIconTimer;
+    QTimer *m_fetchTimer;
+
+    // 等待通过 GetAll 刷新的属性组，同一时间只有一个 GetAll 请求
+    int m_pendingGroups;
+    int m_signalsSinceFetch;
+    bool m_fetching;
+    bool m_ready;
+    FetchStatistics m_fetchStatistics;
 
     QString m_sniServicePath;
     QString m_dbusService;
@@ -111,6 +142,8 @@ private:
 
     QPixmap m_pixmap;
     QPixmap m_overlayPixmap;
+    IconFrameCache m_frameCache;
+    QSet<QPair<int, QString>> m_resolvingIcons;     // 正在后台查找的图标(类型, 图标名)
 
     // SNI propertys
     QString m_sniAttentionIconName;
@@ -15,9 +15,10 @@
 #include <QtConcurrent>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
 
 #include <xcb/xcb_icccm.h>
-#include <X11/Xlib.h>
 
 #define PLUGIN_ENABLED_KEY "enable"
 #define FASHION_MODE_TRAYS_SORTED   "fashion-mode-trays-sorted"
@@ -34,14 +35,7 @@ using namespace Dock;
 TrayPlugin::TrayPlugin(QObject *parent)
     : QObject(parent)
     , m_pluginLoaded(false)
-    , xcb_connection(nullptr)
-    , m_display(nullptr)
 {
-    if (Utils::IS_WAYLAND_DISPLAY) {
-        int screenp = 0;
-        xcb_connection = xcb_connect(qgetenv("DISPLAY"), &screenp);
-        m_display = XOpenDisplay(nullptr);
-    }
 }
 
 const QString TrayPlugin::pluginName() const
@@ -309,65 +303,150 @@ void TrayPlugin::initSNI()
 
 /**
  * @brief TrayPlugin::sniItemsChanged
- * @note 移除关闭的item,插入新增item
+ * @note 移除关闭的item,插入新增item，只处理和上次相比变化的部分，进程ID在后台获取
  */
 void TrayPlugin::sniItemsChanged()
 {
-    const QStringList &itemServicePaths = m_sniWatcher->registeredStatusNotifierItems();
-    QStringList sinTrayKeyList;
+    m_sniServicePaths = m_sniWatcher->registeredStatusNotifierItems();
 
-    for (auto item : itemServicePaths) {
-        sinTrayKeyList << SNITrayWidget::toSNIKey(item);
+    QSet<QString> sniTrayKeys;
+    QSet<QString> services;
+    for (const QString &servicePath : m_sniServicePaths) {
+        sniTrayKeys.insert(SNITrayWidget::toSNIKey(servicePath));
+        services.insert(SNITrayWidget::serviceAndPath(servicePath).first);
     }
-    for (auto itemKey : m_trayMap.keys()) {
-        if (!sinTrayKeyList.contains(itemKey) && SNITrayWidget::isSNIKey(itemKey)) {
-            m_registertedPID.take(m_trayMap[itemKey]->getOwnerPID());
-            trayRemoved(itemKey);
-        }
+
+    QStringList removedKeys;
+    for (auto it = m_trayMap.constBegin(); it != m_trayMap.constEnd(); ++it) {
+        if (SNITrayWidget::isSNIKey(it.key()) && !sniTrayKeys.contains(it.key()))
+            removedKeys << it.key();
     }
-    const QList<QString> &passiveSNIKeyList = m_passiveSNITrayMap.keys();
-    for (auto itemKey : passiveSNIKeyList) {
-        if (!sinTrayKeyList.contains(itemKey) && SNITrayWidget::isSNIKey(itemKey)) {
-            m_passiveSNITrayMap.take(itemKey)->deleteLater();
+    for (const QString &itemKey : removedKeys) {
+        m_registertedPID.take(m_trayMap[itemKey]->getOwnerPID());
+        trayRemoved(itemKey);
+    }
+
+    for (auto it = m_passiveSNITrayMap.begin(); it != m_passiveSNITrayMap.end();) {
+        if (!sniTrayKeys.contains(it.key())) {
+            it.value()->deleteLater();
+            it = m_passiveSNITrayMap.erase(it);
+        } else {
+            ++it;
         }
     }
-    for (int i = 0; i < sinTrayKeyList.size(); ++i) {
-        uint pid = SNITrayWidget::servicePID(itemServicePaths.at(i));
-        if (m_registertedPID.value(pid, REGISTERTED_WAY_IS_SNI) == REGISTERTED_WAY_IS_SNI) {
-            traySNIAdded(sinTrayKeyList.at(i), itemServicePaths.at(i));
-            m_registertedPID.insert(pid, REGISTERTED_WAY_IS_SNI);
+
+    for (auto it = m_initingSNITrayMap.begin(); it != m_initingSNITrayMap.end();) {
+        if (!sniTrayKeys.contains(it.key())) {
+            it.value()->deleteLater();
+            it = m_initingSNITrayMap.erase(it);
+        } else {
+            ++it;
         }
     }
+
+    // 服务注销后，相同的服务名可能被其它进程使用，缓存的进程ID失效
+    for (auto it = m_servicePIDs.begin(); it != m_servicePIDs.end();) {
+        if (!services.contains(it.key()))
+            it = m_servicePIDs.erase(it);
+        else
+            ++it;
+    }
+
+    for (const QString &servicePath : m_sniServicePaths) {
+        const QString &itemKey = SNITrayWidget::toSNIKey(servicePath);
+        if (m_trayMap.contains(itemKey) || m_passiveSNITrayMap.contains(itemKey) || m_initingSNITrayMap.contains(itemKey))
+            continue;
+
+        const QString &service = SNITrayWidget::serviceAndPath(servicePath).first;
+        if (m_servicePIDs.contains(service))
+            sniItemAdded(servicePath, m_servicePIDs.value(service));
+        else
+            resolveServicePID(service);
+    }
+}
+
+void TrayPlugin::sniItemAdded(const QString &servicePath, uint pid)
+{
+    if (m_registertedPID.value(pid, REGISTERTED_WAY_IS_SNI) == REGISTERTED_WAY_IS_SNI) {
+        traySNIAdded(SNITrayWidget::toSNIKey(servicePath), servicePath);
+        m_registertedPID.insert(pid, REGISTERTED_WAY_IS_SNI);
+    }
+}
+
+/**
+ * @brief TrayPlugin::resolveServicePID 异步获取服务所在的进程ID，登录时大量托盘同时注册也不会阻塞界面
+ * @param service 服务名
+ */
+void TrayPlugin::resolveServicePID(const QString &service)
+{
+    if (m_resolvingServices.contains(service))
+        return;
+
+    m_resolvingServices.insert(service);
+
+    QDBusPendingCall call = QDBusConnection::sessionBus().interface()->asyncCall("GetConnectionUnixProcessID", service);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [ = ] {
+        watcher->deleteLater();
+        m_resolvingServices.remove(service);
+
+        // 获取失败时和servicePid的结果一样，按0处理
+        QDBusPendingReply<uint> reply = *watcher;
+        if (reply.isError())
+            qDebug() << "get pid of sni service failed:" << service << reply.error().message();
+
+        const uint pid = reply.isError() ? 0 : reply.value();
+
+        // 获取期间服务可能已经注销
+        bool registered = false;
+        for (const QString &servicePath : m_sniServicePaths) {
+            if (SNITrayWidget::serviceAndPath(servicePath).first != service)
+                continue;
+
+            registered = true;
+            const QString &itemKey = SNITrayWidget::toSNIKey(servicePath);
+            if (!m_trayMap.contains(itemKey) && !m_passiveSNITrayMap.contains(itemKey) && !m_initingSNITrayMap.contains(itemKey))
+                sniItemAdded(servicePath, pid);
+        }
+
+        if (registered)
+            m_servicePIDs.insert(service, pid);
+    });
 }
 
 void TrayPlugin::xembedItemsChanged()
 {
     QList<quint32> winidList = m_trayInter->trayIcons();
-    QStringList newlyAddedTrayKeyList;
-    QStringList allKeytary;
-    QList<quint32> newlyAddedWindowID;
+    QSet<QString> xembedTrayKeys;
+
+    // 一次性获取所有新托盘窗口的信息，避免每个窗口多次往返
+    XEmbedTrayWidget::syncWindowInfo(winidList);
+
+    QStringList removedKeys;
+    for (auto winid : winidList)
+        xembedTrayKeys.insert(XEmbedTrayWidget::toXEmbedKey(winid));
+
+    for (auto it = m_trayMap.constBegin(); it != m_trayMap.constEnd(); ++it) {
+        if (XEmbedTrayWidget::isXEmbedKey(it.key()) && !xembedTrayKeys.contains(it.key()))
+            removedKeys << it.key();
+    }
+    for (const QString &itemKey : removedKeys) {
+        m_registertedPID.take(m_trayMap[itemKey]->getOwnerPID());
+        trayRemoved(itemKey);
+    }
 
     for (auto winid : winidList) {
-        uint pid = XEmbedTrayWidget::getWindowPID(winid);
-        allKeytary << XEmbedTrayWidget::toXEmbedKey(winid);
+        const QString &itemKey = XEmbedTrayWidget::toXEmbedKey(winid);
+        if (m_trayMap.contains(itemKey))
+            continue;
 
+        // 窗口信息已经在上面统一获取，这里不会再产生往返
+        uint pid = XEmbedTrayWidget::getWindowPID(winid);
         if (m_registertedPID.value(pid, REGISTERTED_WAY_IS_XEMBED) == REGISTERTED_WAY_IS_XEMBED) {
             m_registertedPID.insert(pid, REGISTERTED_WAY_IS_XEMBED);
-            newlyAddedWindowID << winid;
-            newlyAddedTrayKeyList << XEmbedTrayWidget::toXEmbedKey(winid);
-        }
-    }
-
-    for (auto tray : m_trayMap.keys()) {
-        if (!allKeytary.contains(tray) && XEmbedTrayWidget::isXEmbedKey(tray)) {
-            m_registertedPID.take(m_trayMap[tray]->getOwnerPID());
-            trayRemoved(tray);
+            trayXEmbedAdded(itemKey, winid);
         }
     }
-
-    for (int i = 0; i < newlyAddedTrayKeyList.size(); ++i) {
-        trayXEmbedAdded(newlyAddedTrayKeyList.at(i), newlyAddedWindowID.at(i));
-    }
 }
 
 void TrayPlugin::addTrayWidget(const QString &itemKey, AbstractTrayWidget *trayWidget)
@@ -402,7 +481,7 @@ void TrayPlugin::trayXEmbedAdded(const QString &itemKey, quint32 winId)
     if (!Utils::SettingValue("com.deepin.dde.dock.module.systemtray", QByteArray(), "enable", false).toBool())
         return;
 
-    AbstractTrayWidget *trayWidget = Utils::IS_WAYLAND_DISPLAY ? new XEmbedTrayWidget(winId, xcb_connection, m_display) : new XEmbedTrayWidget(winId);
+    AbstractTrayWidget *trayWidget = new XEmbedTrayWidget(winId);
     if (trayWidget->isValid())
         addTrayWidget(itemKey, trayWidget);
     else {
@@ -420,24 +499,36 @@ void TrayPlugin::traySNIAdded(const QString &itemKey, const QString &sniServiceP
             return;
         }
 
-        std::lock_guard<std::mutex> lock(m_sniMutex);
-        if (m_trayMap.contains(itemKey) || m_passiveSNITrayMap.contains(itemKey)) {
+        if (m_trayMap.contains(itemKey) || m_passiveSNITrayMap.contains(itemKey) || m_initingSNITrayMap.contains(itemKey)) {
             return;
         }
 
-        SNITrayWidget *trayWidget = new SNITrayWidget(sniServicePath);
+        SNITrayWidget *trayWidget = new SNITrayWidget(sniServicePath, m_servicePIDs.value(SNITrayWidget::serviceAndPath(sniServicePath).first));
 
         // TODO(lxz): 在future里已经对dbus进行过检查了，这里应该不需要再次检查。
-        if (!trayWidget->isValid())
+        if (!trayWidget->isValid()) {
+            trayWidget->deleteLater();
             return;
-
-        if (trayWidget->status() == SNITrayWidget::ItemStatus::Passive) {
-            m_passiveSNITrayMap.insert(itemKey, trayWidget);
-        } else {
-            addTrayWidget(itemKey, trayWidget);
         }
 
-        connect(trayWidget, &SNITrayWidget::statusChanged, this, &TrayPlugin::onSNIItemStatusChanged);
+        // 属性是异步获取的，获取到状态和Id之后再添加，否则Passive的托盘会先显示出来，保存的位置也找不到
+        m_initingSNITrayMap.insert(itemKey, trayWidget);
+        connect(trayWidget, &SNITrayWidget::ready, this, [ = ] {
+            // 等待期间托盘可能已经注销
+            if (m_initingSNITrayMap.value(itemKey) != trayWidget)
+                return;
+
+            m_initingSNITrayMap.remove(itemKey);
+
+            std::lock_guard<std::mutex> lock(m_sniMutex);
+            if (trayWidget->status() == SNITrayWidget::ItemStatus::Passive) {
+                m_passiveSNITrayMap.insert(itemKey, trayWidget);
+            } else {
+                addTrayWidget(itemKey, trayWidget);
+            }
+
+            connect(trayWidget, &SNITrayWidget::statusChanged, this, &TrayPlugin::onSNIItemStatusChanged);
+        });
     });
 
     // Start the computation.
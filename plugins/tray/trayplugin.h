@@ -16,6 +16,8 @@
 
 #include <QSettings>
 #include <QLabel>
+#include <QHash>
+#include <QSet>
 
 #include <mutex>
 #include <xcb/xcb.h>
@@ -25,8 +27,6 @@ namespace Dock {
 class TipsWidget;
 }
 
-typedef struct _XDisplay Display;
-
 class TrayPlugin : public QObject, PluginsItemInterface
 {
     Q_OBJECT
@@ -59,6 +59,8 @@ private:
     bool isSystemTrayItem(const QString &itemKey);
     QString itemKeyOfTrayWidget(AbstractTrayWidget *trayWidget);
     Dock::DisplayMode displayMode();
+    void sniItemAdded(const QString &servicePath, uint pid);
+    void resolveServicePID(const QString &service);
 
 private slots:
     void initXEmbed();
@@ -86,14 +88,16 @@ private:
 
     QMap<QString, AbstractTrayWidget *> m_trayMap;
     QMap<QString, SNITrayWidget *> m_passiveSNITrayMap;     //这个目前好像无用了
+    QMap<QString, SNITrayWidget *> m_initingSNITrayMap;     // 还没有获取到属性的SNI托盘，获取后再添加
     QMap<QString, IndicatorTray*> m_indicatorMap;           //这个有键盘跟license
     QMap<uint, char> m_registertedPID;
 
+    QStringList m_sniServicePaths;                          // 最近一次获取到的SNI托盘
+    QHash<QString, uint> m_servicePIDs;                     // SNI服务名到进程ID的缓存
+    QSet<QString> m_resolvingServices;                      // 正在获取进程ID的服务
+
     bool m_pluginLoaded;
     std::mutex m_sniMutex;
-
-    xcb_connection_t *xcb_connection;
-    Display *m_display;
 };
 
 #endif // TRAYPLUGIN_H
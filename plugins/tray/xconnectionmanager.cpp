@@ -0,0 +1,236 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "xconnectionmanager.h"
+#include "utils.h"
+
+#include <QApplication>
+#include <QThread>
+#include <QX11Info>
+#include <QScopedPointer>
+#include <QDebug>
+
+#include <X11/Xlib.h>
+#include <X11/Xlib-xcb.h>
+
+#include <QAbstractEventDispatcher>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <cerrno>
+#include <cstring>
+
+/**
+ * @brief The XEventReader class
+ * wayland下读取插件连接上的事件，不占用主线程
+ */
+class XEventReader : public QThread
+{
+public:
+    explicit XEventReader(XConnectionManager *manager)
+        : QThread(manager)
+        , m_manager(manager)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        xcb_connection_t *c = m_manager->connection();
+        pollfd fds[2];
+        fds[0].fd = xcb_get_file_descriptor(c);
+        fds[0].events = POLLIN;
+        fds[1].fd = m_manager->m_wakeFd;
+        fds[1].events = POLLIN;
+
+        while (!isInterruptionRequested() && !xcb_connection_has_error(c)) {
+            // 主线程等待回复时读入xcb队列的事件由主线程在空闲前取出，这里只需要等待socket上的数据，不需要超时
+            fds[0].revents = fds[1].revents = 0;
+            if (poll(fds, 2, -1) < 0 && errno != EINTR)
+                break;
+
+            if (fds[1].revents & POLLIN) {
+                eventfd_t value;
+                eventfd_read(fds[1].fd, &value);
+            }
+
+            m_manager->takeEvents(true);
+        }
+    }
+
+private:
+    XConnectionManager *m_manager;
+};
+
+XConnectionManager::XConnectionManager(QObject *parent)
+    : QObject(parent)
+    , m_display(nullptr)
+    , m_connection(nullptr)
+    , m_reader(nullptr)
+    , m_wakeFd(-1)
+{
+    if (!Utils::IS_WAYLAND_DISPLAY) {
+        m_display = QX11Info::display();
+        m_connection = QX11Info::connection();
+        qApp->installNativeEventFilter(this);
+        return;
+    }
+
+    // 插件生命周期内只打开这一个连接，进程退出时随之关闭
+    m_display = XOpenDisplay(nullptr);
+    if (!m_display) {
+        qWarning() << "connect to xserver failed";
+        return;
+    }
+
+    // 事件由xcb读取，Xlib只用来发送XTest等请求
+    XSetEventQueueOwner(m_display, XCBOwnsEventQueue);
+    m_connection = XGetXCBConnection(m_display);
+
+    // 用于退出时唤醒读取线程
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeFd < 0) {
+        qWarning() << "create eventfd failed:" << strerror(errno);
+        return;
+    }
+
+    // 主线程中读取回复时，xcb可能顺带把事件读入了队列，socket上不会再有数据唤醒读取线程，
+    // 所以在主线程空闲前把队列中的事件取出
+    connect(QAbstractEventDispatcher::instance(thread()), &QAbstractEventDispatcher::aboutToBlock, this, [ = ] {
+        takeEvents(false);
+    }, Qt::DirectConnection);
+
+    m_reader = new XEventReader(this);
+    m_reader->start();
+
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &XConnectionManager::stopReader);
+}
+
+void XConnectionManager::internAtoms(const QList<QByteArray> &names, bool onlyIfExists)
+{
+    if (!m_connection)
+        return;
+
+    // 先发送所有请求再读取回复，只需要一次往返
+    QList<QByteArray> requestNames;
+    QVector<xcb_intern_atom_cookie_t> cookies;
+    for (const QByteArray &name : names) {
+        if (m_atoms.contains(name))
+            continue;
+
+        requestNames << name;
+        cookies << xcb_intern_atom(m_connection, onlyIfExists, uint16_t(name.size()), name.constData());
+    }
+
+    for (int i = 0; i < cookies.size(); ++i) {
+        QScopedPointer<xcb_intern_atom_reply_t, QScopedPointerPodDeleter> reply(xcb_intern_atom_reply(m_connection, cookies.at(i), nullptr));
+        if (reply && reply->atom != XCB_ATOM_NONE)
+            m_atoms.insert(requestNames.at(i), reply->atom);
+    }
+}
+
+xcb_atom_t XConnectionManager::atom(const QByteArray &name, bool onlyIfExists)
+{
+    internAtoms({name}, onlyIfExists);
+    return m_atoms.value(name, XCB_ATOM_NONE);
+}
+
+/**
+ * @brief XConnectionManager::windowProperty 读取窗口的字符串属性
+ * @return 属性不存在时返回空
+ */
+QByteArray XConnectionManager::windowProperty(xcb_window_t window, const QByteArray &name)
+{
+    const xcb_atom_t propAtom = atom(name);
+    if (propAtom == XCB_ATOM_NONE)
+        return QByteArray();
+
+    auto cookie = xcb_get_property(m_connection, false, window, propAtom, XCB_GET_PROPERTY_TYPE_ANY, 0, 100);
+    QScopedPointer<xcb_get_property_reply_t, QScopedPointerPodDeleter> reply(xcb_get_property_reply(m_connection, cookie, nullptr));
+
+    return propertyString(reply.data());
+}
+
+// 和XGetWindowProperty的结果一样，只取第一个字符串
+QByteArray XConnectionManager::propertyString(xcb_get_property_reply_t *reply)
+{
+    if (!reply)
+        return QByteArray();
+
+    const char *data = static_cast<const char *>(xcb_get_property_value(reply));
+    const int length = xcb_get_property_value_length(reply);
+
+    return QByteArray(data, int(strnlen(data, size_t(length))));
+}
+
+bool XConnectionManager::nativeEventFilter(const QByteArray &eventType, void *message, long *result)
+{
+    Q_UNUSED(result);
+
+    if (eventType == "xcb_generic_event_t")
+        Q_EMIT eventReceived(static_cast<xcb_generic_event_t *>(message));
+
+    // 事件仍然交给Qt处理
+    return false;
+}
+
+void XConnectionManager::dispatchEvents()
+{
+    QVector<xcb_generic_event_t *> events;
+    {
+        QMutexLocker locker(&m_eventsMutex);
+        events.swap(m_events);
+    }
+
+    for (xcb_generic_event_t *event : events) {
+        Q_EMIT eventReceived(event);
+        free(event);
+    }
+}
+
+void XConnectionManager::stopReader()
+{
+    if (!m_reader)
+        return;
+
+    disconnect(QAbstractEventDispatcher::instance(thread()), nullptr, this, nullptr);
+
+    m_reader->requestInterruption();
+    eventfd_write(m_wakeFd, 1);
+    m_reader->wait();
+    m_reader = nullptr;
+
+    ::close(m_wakeFd);
+    m_wakeFd = -1;
+
+    // 线程退出后剩余的事件不再处理
+    QMutexLocker locker(&m_eventsMutex);
+    for (xcb_generic_event_t *event : m_events)
+        free(event);
+    m_events.clear();
+}
+
+/**
+ * @brief XConnectionManager::takeEvents 取出连接上的事件，主线程还没处理上一批时只追加不再通知
+ * @param readSocket 是否从socket读取，否则只取出xcb队列中已有的事件
+ * @note 读取线程和主线程都会调用，取出和追加都在锁内完成，保证事件的顺序
+ */
+void XConnectionManager::takeEvents(bool readSocket)
+{
+    QMutexLocker locker(&m_eventsMutex);
+    const bool notify = m_events.isEmpty();
+
+    xcb_generic_event_t *event = readSocket ? xcb_poll_for_event(m_connection) : xcb_poll_for_queued_event(m_connection);
+    while (event) {
+        m_events << event;
+        event = xcb_poll_for_queued_event(m_connection);
+    }
+
+    const bool hasEvents = !m_events.isEmpty();
+    locker.unlock();
+
+    if (notify && hasEvents)
+        QMetaObject::invokeMethod(this, "dispatchEvents", Qt::QueuedConnection);
+}
@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef XCONNECTIONMANAGER_H
+#define XCONNECTIONMANAGER_H
+
+#include "singleton.h"
+
+#include <QObject>
+#include <QAbstractNativeEventFilter>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+
+#include <xcb/xcb.h>
+
+typedef struct _XDisplay Display;
+
+class QThread;
+
+/**
+ * @brief The XConnectionManager class
+ * @note 托盘插件中所有XEmbed托盘共用的X连接。X11下直接使用Qt的连接；wayland下整个插件只打开一个连接，
+ * @note 由单独的线程读取事件，攒成一批后交给主线程处理。同时缓存atom，提供窗口属性的读取
+ */
+class XConnectionManager : public QObject, public QAbstractNativeEventFilter, public Singleton<XConnectionManager>
+{
+    Q_OBJECT
+    friend class Singleton<XConnectionManager>;
+    friend class XEventReader;
+
+public:
+    xcb_connection_t *connection() const { return m_connection; }
+    Display *display() const { return m_display; }
+
+    void internAtoms(const QList<QByteArray> &names, bool onlyIfExists = true);
+    xcb_atom_t atom(const QByteArray &name, bool onlyIfExists = true);
+    QByteArray windowProperty(xcb_window_t window, const QByteArray &name);
+
+    static QByteArray propertyString(xcb_get_property_reply_t *reply);
+
+Q_SIGNALS:
+    // 只在主线程中发出，槽函数返回后事件会被释放
+    void eventReceived(xcb_generic_event_t *event);
+
+protected:
+    bool nativeEventFilter(const QByteArray &eventType, void *message, long *result) override;
+
+private Q_SLOTS:
+    void dispatchEvents();
+    void stopReader();
+
+private:
+    explicit XConnectionManager(QObject *parent = nullptr);
+
+    void takeEvents(bool readSocket);
+
+private:
+    Display *m_display;
+    xcb_connection_t *m_connection;
+    QThread *m_reader;
+    int m_wakeFd;
+
+    QMutex m_eventsMutex;
+    QVector<xcb_generic_event_t *> m_events;
+
+    // atom在X服务端全局有效，进程内缓存后不需要再次请求
+    QHash<QByteArray, xcb_atom_t> m_atoms;
+};
+
+#endif // XCONNECTIONMANAGER_H
@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "xembeddamagedispatcher.h"
+#include "xembedtraywidget.h"
+#include "xconnectionmanager.h"
+
+#include <QTimer>
+#include <QDebug>
+
+#include <xcb/damage.h>
+
+XEmbedDamageDispatcher::XEmbedDamageDispatcher(QObject *parent)
+    : QObject(parent)
+    , m_connection(nullptr)
+    , m_damageEventBase(0)
+    , m_flushTimer(new QTimer(this))
+{
+    // 一帧内的多次变化只截图一次
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(16);
+
+    connect(m_flushTimer, &QTimer::timeout, this, &XEmbedDamageDispatcher::flush);
+}
+
+/**
+ * @brief XEmbedDamageDispatcher::watch 监听托盘窗口的内容变化，变化时调用托盘的refershIconImage
+ * @return 不支持Damage扩展时返回false，需要托盘自己刷新
+ */
+bool XEmbedDamageDispatcher::watch(xcb_window_t window, XEmbedTrayWidget *widget)
+{
+    if (!init())
+        return false;
+
+    unwatch(window);
+
+    Client client;
+    client.damage = xcb_generate_id(m_connection);
+    client.widget = widget;
+
+    // NON_EMPTY级别下，区域从空变为非空时才会通知，刷新前清空区域
+    xcb_damage_create(m_connection, client.damage, window, XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+    xcb_flush(m_connection);
+
+    m_clients.insert(window, client);
+
+    return true;
+}
+
+void XEmbedDamageDispatcher::unwatch(xcb_window_t window)
+{
+    if (!m_clients.contains(window))
+        return;
+
+    const Client client = m_clients.take(window);
+    m_damagedWindows.remove(window);
+
+    // 托盘窗口销毁时Damage对象会被一起销毁，此时的错误直接忽略
+    xcb_discard_reply(m_connection, xcb_damage_destroy_checked(m_connection, client.damage).sequence);
+    xcb_flush(m_connection);
+}
+
+void XEmbedDamageDispatcher::flush()
+{
+    const QSet<xcb_window_t> windows = m_damagedWindows;
+    m_damagedWindows.clear();
+
+    for (xcb_window_t window : windows) {
+        const Client &client = m_clients.value(window);
+        if (!client.widget)
+            continue;
+
+        // 先清空区域再截图，截图期间的变化会再次通知
+        xcb_damage_subtract(m_connection, client.damage, XCB_NONE, XCB_NONE);
+        client.widget->refershIconImage();
+    }
+
+    xcb_flush(m_connection);
+}
+
+bool XEmbedDamageDispatcher::init()
+{
+    if (m_connection)
+        return m_damageEventBase;
+
+    xcb_connection_t *c = XConnectionManager::instance()->connection();
+    if (!c)
+        return false;
+
+    m_connection = c;
+
+    const xcb_query_extension_reply_t *extension = xcb_get_extension_data(c, &xcb_damage_id);
+    if (!extension || !extension->present) {
+        qWarning() << "damage extension is not supported, tray icons will be refreshed by timer";
+        return false;
+    }
+
+    // 使用Damage扩展前需要先协商版本
+    xcb_damage_query_version_reply_t *reply = xcb_damage_query_version_reply(c, xcb_damage_query_version(c, XCB_DAMAGE_MAJOR_VERSION, XCB_DAMAGE_MINOR_VERSION), nullptr);
+    if (!reply)
+        return false;
+
+    free(reply);
+
+    m_damageEventBase = extension->first_event;
+
+    connect(XConnectionManager::instance(), &XConnectionManager::eventReceived, this, &XEmbedDamageDispatcher::handleEvent);
+
+    return true;
+}
+
+void XEmbedDamageDispatcher::handleEvent(xcb_generic_event_t *event)
+{
+    if (!m_damageEventBase || (event->response_type & ~0x80) != m_damageEventBase + XCB_DAMAGE_NOTIFY)
+        return;
+
+    xcb_damage_notify_event_t *notify = reinterpret_cast<xcb_damage_notify_event_t *>(event);
+    auto it = m_clients.constFind(notify->drawable);
+    if (it == m_clients.constEnd())
+        return;
+
+    // 托盘窗口变大时截图失败不会触发，按事件中的窗口大小更新截图区域
+    const QSize size(notify->geometry.width, notify->geometry.height);
+    if (it->widget && !size.isEmpty())
+        it->widget->m_clientSize = size;
+
+    m_damagedWindows.insert(notify->drawable);
+    if (!m_flushTimer->isActive())
+        m_flushTimer->start();
+}
@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef XEMBEDDAMAGEDISPATCHER_H
+#define XEMBEDDAMAGEDISPATCHER_H
+
+#include "singleton.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QHash>
+#include <QSet>
+
+#include <xcb/xcb.h>
+
+class QTimer;
+class XEmbedTrayWidget;
+
+/**
+ * @brief The XEmbedDamageDispatcher class
+ * @note 托盘插件中统一处理XEmbed托盘窗口的Damage事件，同一帧内的变化合并后只刷新发生变化的托盘图标，
+ * @note 事件由XConnectionManager读取
+ */
+class XEmbedDamageDispatcher : public QObject, public Singleton<XEmbedDamageDispatcher>
+{
+    Q_OBJECT
+    friend class Singleton<XEmbedDamageDispatcher>;
+
+public:
+    bool watch(xcb_window_t window, XEmbedTrayWidget *widget);
+    void unwatch(xcb_window_t window);
+
+private Q_SLOTS:
+    void handleEvent(xcb_generic_event_t *event);
+    void flush();
+
+private:
+    explicit XEmbedDamageDispatcher(QObject *parent = nullptr);
+
+    bool init();
+
+private:
+    struct Client {
+        uint32_t damage;
+        QPointer<XEmbedTrayWidget> widget;
+    };
+
+    xcb_connection_t *m_connection;
+    uint8_t m_damageEventBase;      // 为0时表示不支持Damage扩展
+    QTimer *m_flushTimer;
+
+    QHash<xcb_window_t, Client> m_clients;
+    QSet<xcb_window_t> m_damagedWindows;
+};
+
+#endif // XEMBEDDAMAGEDISPATCHER_H
@@ -4,6 +4,8 @@
 
 #include "constants.h"
 #include "xembedtraywidget.h"
+#include "xembeddamagedispatcher.h"
+#include "xconnectionmanager.h"
 #include "utils.h"
 
 #include <QWindow>
@@ -17,6 +19,8 @@
 #include <QApplication>
 #include <QScreen>
 #include <QMap>
+#include <QHash>
+#include <QVector>
 #include <QGuiApplication>
 
 #include <X11/extensions/shape.h>
@@ -26,6 +30,11 @@
 #include <xcb/composite.h>
 #include <xcb/xcb_image.h>
 #include <xcb/xproto.h>
+#include <xcb/shm.h>
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <cstring>
 
 #define NORMAL_WINDOW_PROP_NAME "WM_CLASS"
 #define WINE_WINDOW_PROP_NAME "__wine_prefix"
@@ -64,16 +73,116 @@ void sni_cleanup_xcb_image(void *data)
     xcb_image_destroy(static_cast<xcb_image_t*>(data));
 }
 
-XEmbedTrayWidget::XEmbedTrayWidget(quint32 winId, xcb_connection_t *cnn, Display *disp, QWidget *parent)
+/**
+ * @brief The XEmbedWindowInfo struct
+ * 嵌入托盘窗口前需要的窗口信息，多个窗口的请求一起发送后再读取回复
+ */
+struct XEmbedWindowInfo {
+    bool valid = false;
+    QSize size;
+    bool buttonPressSelected = true;
+    QByteArray wmClass;
+    QByteArray winePrefix;
+    uint pid = 0;
+};
+
+static QHash<quint32, XEmbedWindowInfo> WindowInfoCache;
+
+/**
+ * @brief fetchWindowInfo 先发送所有窗口的请求再统一读取回复，N个窗口只需要一次往返
+ */
+static void fetchWindowInfo(xcb_connection_t *c, const QList<quint32> &winIds)
+{
+    XConnectionManager *manager = XConnectionManager::instance();
+    manager->internAtoms({NORMAL_WINDOW_PROP_NAME, WINE_WINDOW_PROP_NAME, "_NET_WM_PID"});
+    const xcb_atom_t wmClassAtom = manager->atom(NORMAL_WINDOW_PROP_NAME);
+    const xcb_atom_t winePrefixAtom = manager->atom(WINE_WINDOW_PROP_NAME);
+    const xcb_atom_t pidAtom = manager->atom("_NET_WM_PID");
+
+    struct Cookies {
+        xcb_get_geometry_cookie_t geometry;
+        xcb_get_window_attributes_cookie_t attributes;
+        xcb_get_property_cookie_t wmClass;
+        xcb_get_property_cookie_t winePrefix;
+        xcb_get_property_cookie_t pid;
+    };
+
+    QVector<Cookies> cookies;
+    for (quint32 winId : winIds) {
+        Cookies cookie;
+        cookie.geometry = xcb_get_geometry(c, winId);
+        cookie.attributes = xcb_get_window_attributes(c, winId);
+        cookie.wmClass.sequence = wmClassAtom ? xcb_get_property(c, false, winId, wmClassAtom, XCB_GET_PROPERTY_TYPE_ANY, 0, 100).sequence : 0;
+        cookie.winePrefix.sequence = winePrefixAtom ? xcb_get_property(c, false, winId, winePrefixAtom, XCB_GET_PROPERTY_TYPE_ANY, 0, 100).sequence : 0;
+        cookie.pid.sequence = pidAtom ? xcb_get_property(c, false, winId, pidAtom, XCB_ATOM_CARDINAL, 0, 1).sequence : 0;
+        cookies << cookie;
+    }
+
+    for (int i = 0; i < cookies.size(); ++i) {
+        const Cookies &cookie = cookies.at(i);
+        XEmbedWindowInfo info;
+
+        QScopedPointer<xcb_get_geometry_reply_t, QScopedPointerPodDeleter> geometry(xcb_get_geometry_reply(c, cookie.geometry, nullptr));
+        if (geometry) {
+            info.valid = true;
+            info.size = QSize(geometry->width, geometry->height);
+        }
+
+        QScopedPointer<xcb_get_window_attributes_reply_t, QScopedPointerPodDeleter> attributes(xcb_get_window_attributes_reply(c, cookie.attributes, nullptr));
+        if (attributes)
+            info.buttonPressSelected = attributes->all_event_masks & XCB_EVENT_MASK_BUTTON_PRESS;
+
+        if (cookie.wmClass.sequence) {
+            QScopedPointer<xcb_get_property_reply_t, QScopedPointerPodDeleter> reply(xcb_get_property_reply(c, cookie.wmClass, nullptr));
+            info.wmClass = XConnectionManager::propertyString(reply.data());
+        }
+
+        if (cookie.winePrefix.sequence) {
+            QScopedPointer<xcb_get_property_reply_t, QScopedPointerPodDeleter> reply(xcb_get_property_reply(c, cookie.winePrefix, nullptr));
+            info.winePrefix = XConnectionManager::propertyString(reply.data());
+        }
+
+        if (cookie.pid.sequence) {
+            QScopedPointer<xcb_get_property_reply_t, QScopedPointerPodDeleter> reply(xcb_get_property_reply(c, cookie.pid, nullptr));
+            if (reply && xcb_get_property_value_length(reply.data()) >= int(sizeof(uint32_t)))
+                info.pid = *static_cast<uint32_t *>(xcb_get_property_value(reply.data()));
+        }
+
+        WindowInfoCache.insert(winIds.at(i), info);
+    }
+}
+
+static XEmbedWindowInfo windowInfo(quint32 winId)
+{
+    if (!WindowInfoCache.contains(winId)) {
+        xcb_connection_t *c = XConnectionManager::instance()->connection();
+        if (!c)
+            return XEmbedWindowInfo();
+
+        fetchWindowInfo(c, {winId});
+    }
+
+    return WindowInfoCache.value(winId);
+}
+
+XEmbedTrayWidget::XEmbedTrayWidget(quint32 winId, QWidget *parent)
     : AbstractTrayWidget(parent)
     , m_windowId(winId)
     , m_appName(getAppNameForWindow(winId))
     , m_valid(true)
-    , m_xcbCnn(cnn)
-    , m_display(disp)
+    , m_xcbCnn(XConnectionManager::instance()->connection())
+    , m_display(XConnectionManager::instance()->display())
     , m_injectMode(Direct)
+    , m_shmSeg(0)
+    , m_shmAddr(nullptr)
+    , m_shmSize(0)
+    , m_shmUnsupported(false)
+    , m_damageWatched(false)
 {
     wrapWindow();
+    if (m_valid)
+        m_damageWatched = XEmbedDamageDispatcher::instance()->watch(m_windowId, this);
+
     setOwnerPID(getWindowPID(winId));
 
     m_updateTimer = new QTimer(this);
@@ -95,17 +204,26 @@ XEmbedTrayWidget::XEmbedTrayWidget(quint32 winId, xcb_connection_t *cnn, Display
 XEmbedTrayWidget::~XEmbedTrayWidget()
 {
     AppWinidSuffixMap[m_appName].remove(m_windowId);
+
+    if (m_damageWatched)
+        XEmbedDamageDispatcher::instance()->unwatch(m_windowId);
+
+    releaseShm(m_xcbCnn);
 }
 
 QString XEmbedTrayWidget::itemKeyForConfig()
 {
-    return QString("window:%1").arg(getAppNameForWindow(m_windowId));
+    return QString("window:%1").arg(m_appName);
 }
 
 void XEmbedTrayWidget::showEvent(QShowEvent *e)
 {
     QWidget::showEvent(e);
 
+    // 图标变化时会收到Damage事件，已有图标时不需要刷新
+    if (m_damageWatched && !m_image.isNull())
+        return;
+
     m_updateTimer->start();
 }
 
@@ -141,7 +259,7 @@ void XEmbedTrayWidget::mouseMoveEvent(QMouseEvent *e)
 
 void XEmbedTrayWidget::configContainerPosition()
 {
-    auto c = IS_WAYLAND_DISPLAY ? m_xcbCnn : QX11Info::connection();
+    auto c = m_xcbCnn;
     if (!c) {
         qWarning() << "QX11Info::connection() is " << c;
         return;
@@ -165,15 +283,15 @@ void XEmbedTrayWidget::configContainerPosition()
 
 void XEmbedTrayWidget::wrapWindow()
 {
-    auto c = IS_WAYLAND_DISPLAY ? m_xcbCnn : QX11Info::connection();
+    auto c = m_xcbCnn;
     if (!c) {
         qWarning() << "QX11Info::connection() is " << c;
         return;
     }
 
-    auto cookie = xcb_get_geometry(c, m_windowId);
-    QScopedPointer<xcb_get_geometry_reply_t, QScopedPointerPodDeleter> clientGeom(xcb_get_geometry_reply(c, cookie, nullptr));
-    if (!clientGeom) {
+    // 窗口信息在创建托盘时已经和其它托盘窗口一起获取
+    const XEmbedWindowInfo &info = windowInfo(m_windowId);
+    if (!info.valid) {
         m_valid = false;
         return;
     }
@@ -216,10 +334,7 @@ void XEmbedTrayWidget::wrapWindow()
         QWindow * win = QWindow::fromWinId(m_containerWid);
         win->setOpacity(0);
     } else {
-        const char* opacityName = "_NET_WM_WINDOW_OPACITY\0";
-        xcb_intern_atom_cookie_t opacityCookie = xcb_intern_atom(c, false, strlen(opacityName), opacityName);
-        xcb_intern_atom_reply_t *opacityReply = xcb_intern_atom_reply(c, opacityCookie, 0);
-        xcb_atom_t opacityAtom = opacityReply->atom;
+        xcb_atom_t opacityAtom = XConnectionManager::instance()->atom("_NET_WM_WINDOW_OPACITY", false);
         quint32 opacity = 10;
         xcb_change_property(c,
                            XCB_PROP_MODE_REPLACE,
@@ -233,8 +348,6 @@ void XEmbedTrayWidget::wrapWindow()
 
 //    setX11PassMouseEvent(true);
 
-    xcb_flush(c);
-
     xcb_map_window(c, m_containerWid);
 
     xcb_reparent_window(c, m_windowId,
@@ -261,21 +374,20 @@ void XEmbedTrayWidget::wrapWindow()
                          XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, windowMoveConfigVals);
 
     // 判断托盘的大小是否超出iconSize
-    QSize clientWindowSize;
-    if (clientGeom) {
-        clientWindowSize = QSize(clientGeom->width, clientGeom->height);
-    }
+    QSize clientWindowSize = info.size;
 
    if (clientWindowSize.isEmpty() || clientWindowSize.width() > iconSize || clientWindowSize.height() > iconSize ) {
 
-        uint16_t widthNormalized = std::min(clientGeom->width, iconSize);
-        uint16_t heighNormalized = std::min(clientGeom->height, iconSize);
+        uint16_t widthNormalized = std::min(uint16_t(info.size.width()), iconSize);
+        uint16_t heighNormalized = std::min(uint16_t(info.size.height()), iconSize);
 
         const uint32_t windowSizeConfigVals[2] = {widthNormalized, heighNormalized};
         xcb_configure_window(c, m_windowId, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, windowSizeConfigVals);
 
-        xcb_flush(c);
         clientWindowSize = QSize(iconSize, iconSize);
+        m_clientSize = QSize(widthNormalized, heighNormalized);
+    } else {
+        m_clientSize = clientWindowSize;
     }
 
     //show the embedded window otherwise nothing happens
@@ -287,11 +399,9 @@ void XEmbedTrayWidget::wrapWindow()
 
     xcb_flush(c);
 
-    // 通过xcb获取window属性，判断该window是否处理button press事件
+    // 通过window属性判断该window是否处理button press事件
     // 当window不关注button press等事件时，使用xtest extension
-    auto windowAttributesCookie = xcb_get_window_attributes(c, m_windowId);
-    QScopedPointer<xcb_get_window_attributes_reply_t, QScopedPointerPodDeleter> windowAttributes(xcb_get_window_attributes_reply(c, windowAttributesCookie, nullptr));
-    if (windowAttributes && !(windowAttributes->all_event_masks & XCB_EVENT_MASK_BUTTON_PRESS)) {
+    if (!info.buttonPressSelected) {
         m_injectMode = XTest;
     }
 
@@ -310,7 +420,7 @@ void XEmbedTrayWidget::sendHoverEvent()
     configContainerPosition();
     setX11PassMouseEvent(false);
     setWindowOnTop(true);
-    Display *display = IS_WAYLAND_DISPLAY ? m_display : QX11Info::display();
+    Display *display = m_display;
     if (display) {
         if (m_injectMode == XTest || IS_WAYLAND_DISPLAY) {
             // fake enter event
@@ -343,6 +453,9 @@ void XEmbedTrayWidget::updateIcon()
 //    if (!isVisible() && !m_active)
 //        return;
 
+    if (m_damageWatched && !m_image.isNull())
+        return;
+
     m_updateTimer->start();
 }
 
@@ -377,7 +490,7 @@ void XEmbedTrayWidget::sendClick(uint8_t mouseButton, int x, int y)
     setX11PassMouseEvent(false);
     setWindowOnTop(true);
 
-    Display *display = IS_WAYLAND_DISPLAY ? m_display : QX11Info::display();
+    Display *display = m_display;
 
     if (m_injectMode == XTest) {
         XTestFakeMotionEvent(display, 0, p.x(), p.y(), CurrentTime);
@@ -426,40 +539,7 @@ void XEmbedTrayWidget::sendClick(uint8_t mouseButton, int x, int y)
 // NOTE: WM_NAME may can not obtain successfully
 QString XEmbedTrayWidget::getWindowProperty(quint32 winId, QString propName)
 {
-    const auto display = IS_WAYLAND_DISPLAY ? XOpenDisplay(nullptr) : QX11Info::display();
-    if (!display) {
-        qWarning() << "QX11Info::display() is " << display;
-        return QString();
-    }
-
-    Atom atom_prop = XInternAtom(display, propName.toLocal8Bit(), true);
-    if (!atom_prop) {
-        qDebug() << "Error: get window property failed, invalid property atom";
-        return QString();
-    }
-
-    Atom actual_type_return;
-    int actual_format_return;
-    unsigned long nitems_return;
-    unsigned long bytes_after_return;
-    unsigned char *prop_return;
-
-    int r = XGetWindowProperty(display, winId, atom_prop, 0, 100, false, AnyPropertyType,
-            &actual_type_return, &actual_format_return, &nitems_return,
-            &bytes_after_return, &prop_return);
-
-    Q_UNUSED(r);
-
-//    qDebug() << (r == Success)
-//             << actual_type_return
-//             << actual_format_return
-//             << nitems_return
-//             << bytes_after_return
-//             << QString::fromLocal8Bit((char*)prop_return);
-    if (IS_WAYLAND_DISPLAY)
-        XCloseDisplay(display);
-
-    return QString::fromLocal8Bit((char*)prop_return);
+    return QString::fromLocal8Bit(XConnectionManager::instance()->windowProperty(winId, propName.toLocal8Bit()));
 }
 
 QString XEmbedTrayWidget::toXEmbedKey(quint32 winId)
@@ -475,18 +555,12 @@ bool XEmbedTrayWidget::isXEmbedKey(const QString &itemKey)
 void XEmbedTrayWidget::refershIconImage()
 {
     const auto ratio = devicePixelRatioF();
-    auto c = IS_WAYLAND_DISPLAY ? m_xcbCnn : QX11Info::connection();
+    auto c = m_xcbCnn;
     if (!c) {
         qWarning() << "QX11Info::connection() is " << c;
         return;
     }
 
-    auto cookie = xcb_get_geometry(c, m_windowId);
-    xcb_get_geometry_reply_t *geom(xcb_get_geometry_reply(c, cookie, Q_NULLPTR));
-    if (!geom) {
-        return;
-    }
-
     xcb_expose_event_t expose;
     expose.response_type = XCB_EXPOSE;
     expose.window = m_containerWid;
@@ -495,21 +569,21 @@ void XEmbedTrayWidget::refershIconImage()
     expose.width = iconDefaultSize * ratio;
     expose.height = iconDefaultSize * ratio;
     xcb_send_event_checked(c, false, m_containerWid, XCB_EVENT_MASK_VISIBILITY_CHANGE, reinterpret_cast<char *>(&expose));
-    xcb_flush(c);
 
-    xcb_image_t *image = xcb_image_get(c, m_windowId, 0, 0, geom->width, geom->height, ~0, XCB_IMAGE_FORMAT_Z_PIXMAP);
-    if (!image) {
-        free(geom);
-        return;
-    }
+    QImage qimage = captureWindowImage(c);
+    // 窗口大小变化后截图区域无效，重新获取窗口大小后再试一次
+    if (qimage.isNull() && m_clientSize.isEmpty())
+        qimage = captureWindowImage(c);
 
-    QImage qimage(image->data, image->width, image->height, image->stride, QImage::Format_ARGB32, sni_cleanup_xcb_image, image);
-    if (qimage.isNull()) {
-         free(geom);
+    if (qimage.isNull())
         return;
-    }
 
-    m_image = qimage.scaled(iconDefaultSize * ratio, iconDefaultSize * ratio, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    // 截图可能引用共享内存，下一次截图时会被覆盖，需要复制
+    const QSize iconSize(iconDefaultSize * ratio, iconDefaultSize * ratio);
+    if (qimage.size() == iconSize)
+        m_image = qimage.copy();
+    else
+        m_image = qimage.scaled(iconSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
     m_image.setDevicePixelRatio(ratio);
 
     update();
@@ -520,18 +594,130 @@ void XEmbedTrayWidget::refershIconImage()
     }
 }
 
+/**
+ * @brief XEmbedTrayWidget::captureWindowImage 获取托盘窗口的图像
+ * @note 优先通过MIT-SHM截图，图像数据不经过socket传输，不支持时使用xcb_image_get
+ * @return 截图失败时返回空，窗口大小变化导致失败时会清空m_clientSize
+ */
+QImage XEmbedTrayWidget::captureWindowImage(xcb_connection_t *c)
+{
+    if (m_clientSize.isEmpty() && !updateClientSize(c))
+        return QImage();
+
+    const uint16_t width = uint16_t(m_clientSize.width());
+    const uint16_t height = uint16_t(m_clientSize.height());
+
+    if (!m_shmUnsupported && attachShm(c, uint32_t(width) * height * 4)) {
+        auto cookie = xcb_shm_get_image(c, m_windowId, 0, 0, width, height, ~0, XCB_IMAGE_FORMAT_Z_PIXMAP, m_shmSeg, 0);
+        xcb_generic_error_t *error = nullptr;
+        QScopedPointer<xcb_shm_get_image_reply_t, QScopedPointerPodDeleter> reply(xcb_shm_get_image_reply(c, cookie, &error));
+        if (!reply) {
+            free(error);
+            m_clientSize = QSize();
+            return QImage();
+        }
+
+        return QImage(static_cast<const uchar *>(m_shmAddr), width, height, width * 4, QImage::Format_ARGB32);
+    }
+
+    xcb_image_t *image = xcb_image_get(c, m_windowId, 0, 0, width, height, ~0, XCB_IMAGE_FORMAT_Z_PIXMAP);
+    if (!image) {
+        m_clientSize = QSize();
+        return QImage();
+    }
+
+    return QImage(image->data, image->width, image->height, image->stride, QImage::Format_ARGB32, sni_cleanup_xcb_image, image);
+}
+
+bool XEmbedTrayWidget::updateClientSize(xcb_connection_t *c)
+{
+    auto cookie = xcb_get_geometry(c, m_windowId);
+    QScopedPointer<xcb_get_geometry_reply_t, QScopedPointerPodDeleter> geom(xcb_get_geometry_reply(c, cookie, nullptr));
+    if (!geom)
+        return false;
+
+    m_clientSize = QSize(geom->width, geom->height);
+    return !m_clientSize.isEmpty();
+}
+
+/**
+ * @brief XEmbedTrayWidget::attachShm 创建共享内存并让X服务端关联，已有的共享内存足够大时直接使用
+ * @note 远程连接或X服务端不支持MIT-SHM时返回false，之后不再尝试
+ */
+bool XEmbedTrayWidget::attachShm(xcb_connection_t *c, uint32_t size)
+{
+    if (m_shmSeg && m_shmSize >= size)
+        return true;
+
+    releaseShm(c);
+
+    const xcb_query_extension_reply_t *extension = xcb_get_extension_data(c, &xcb_shm_id);
+    if (!extension || !extension->present) {
+        m_shmUnsupported = true;
+        return false;
+    }
+
+    const int shmId = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (shmId < 0) {
+        m_shmUnsupported = true;
+        return false;
+    }
+
+    void *addr = shmat(shmId, nullptr, 0);
+    if (addr == reinterpret_cast<void *>(-1)) {
+        shmctl(shmId, IPC_RMID, nullptr);
+        m_shmUnsupported = true;
+        return false;
+    }
+
+    const xcb_shm_seg_t seg = xcb_generate_id(c);
+    xcb_generic_error_t *error = xcb_request_check(c, xcb_shm_attach_checked(c, seg, uint32_t(shmId), false));
+    // X服务端已经关联，标记删除后在双方都断开时由系统回收
+    shmctl(shmId, IPC_RMID, nullptr);
+    if (error) {
+        free(error);
+        shmdt(addr);
+        m_shmUnsupported = true;
+        return false;
+    }
+
+    m_shmSeg = seg;
+    m_shmAddr = addr;
+    m_shmSize = size;
+
+    return true;
+}
+
+void XEmbedTrayWidget::releaseShm(xcb_connection_t *c)
+{
+    if (!m_shmSeg)
+        return;
+
+    if (c) {
+        xcb_shm_detach(c, m_shmSeg);
+        xcb_flush(c);
+    }
+
+    shmdt(m_shmAddr);
+
+    m_shmSeg = 0;
+    m_shmAddr = nullptr;
+    m_shmSize = 0;
+}
+
 QString XEmbedTrayWidget::getAppNameForWindow(quint32 winId)
 {
     QString appName;
     do {
         // is normal application
-        appName = getWindowProperty(winId, NORMAL_WINDOW_PROP_NAME);
+        const XEmbedWindowInfo &info = windowInfo(winId);
+        appName = QString::fromLocal8Bit(info.wmClass);
         if (!appName.isEmpty() && appName != IS_WINE_WINDOW_BY_WM_CLASS) {
             break;
         }
 
         // is wine application
-        appName = getWindowProperty(winId, WINE_WINDOW_PROP_NAME).split("/").last();
+        appName = QString::fromLocal8Bit(info.winePrefix).split("/").last();
         if (!appName.isEmpty()) {
             break;
         }
@@ -611,7 +797,7 @@ void XEmbedTrayWidget::setX11PassMouseEvent(const bool pass)
 
 void XEmbedTrayWidget::setWindowOnTop(const bool top)
 {
-    auto c = IS_WAYLAND_DISPLAY ? m_xcbCnn : QX11Info::connection();
+    auto c = m_xcbCnn;
     if (!c) {
         qWarning() << "QX11Info::connection() is " << c;
         return;
@@ -623,7 +809,7 @@ void XEmbedTrayWidget::setWindowOnTop(const bool top)
 
 bool XEmbedTrayWidget::isBadWindow()
 {
-    auto c = IS_WAYLAND_DISPLAY ? m_xcbCnn : QX11Info::connection();
+    auto c = m_xcbCnn;
 
     auto cookie = xcb_get_geometry(c, m_windowId);
     xcb_get_geometry_reply_t *clientGeom = xcb_get_geometry_reply(c, cookie, Q_NULLPTR);
@@ -636,29 +822,29 @@ bool XEmbedTrayWidget::isBadWindow()
 
 uint XEmbedTrayWidget::getWindowPID(uint winId)
 {
-    const auto display = IS_WAYLAND_DISPLAY ? XOpenDisplay(nullptr) : QX11Info::display();
-    if (!display) {
-        qWarning() << "QX11Info::connection() is " << display;
-        return 0;
-    }
-
-    Atom nameAtom = XInternAtom(display, "_NET_WM_PID", 1);
-    Atom type;
-    int format, status;
-
-    unsigned long nitems, after;
-    unsigned char *data;
-    unsigned int pid = 0;
+    return windowInfo(winId).pid;
+}
 
-    status = XGetWindowProperty(display, winId, nameAtom, 0, 1024, 0,
-            XInternAtom(display, "CARDINAL", 0), &type, &format, &nitems, &after, &data);
-    if (status == Success && data) {
-        pid = *((uint*)data);
-        XFree(data);
+/**
+ * @brief XEmbedTrayWidget::syncWindowInfo 批量获取托盘窗口的信息，并清除已经不在托盘中的窗口的信息
+ * @param winIds 当前所有的托盘窗口
+ */
+void XEmbedTrayWidget::syncWindowInfo(const QList<quint32> &winIds)
+{
+    for (auto it = WindowInfoCache.begin(); it != WindowInfoCache.end();) {
+        if (!winIds.contains(it.key()))
+            it = WindowInfoCache.erase(it);
+        else
+            ++it;
     }
 
-    if (IS_WAYLAND_DISPLAY)
-        XCloseDisplay(display);
+    QList<quint32> newWinIds;
+    for (quint32 winId : winIds) {
+        if (!WindowInfoCache.contains(winId))
+            newWinIds << winId;
+    }
 
-    return pid;
-}
\ No newline at end of file
+    xcb_connection_t *c = XConnectionManager::instance()->connection();
+    if (c && !newWinIds.isEmpty())
+        fetchWindowInfo(c, newWinIds);
+}
@@ -17,9 +17,10 @@ typedef struct _XDisplay Display;
 class XEmbedTrayWidget : public AbstractTrayWidget
 {
     Q_OBJECT
+    friend class XEmbedDamageDispatcher;
 
 public:
-    explicit XEmbedTrayWidget(quint32 winId, xcb_connection_t *cnn = nullptr, Display *disp = nullptr, QWidget *parent = nullptr);
+    explicit XEmbedTrayWidget(quint32 winId, QWidget *parent = nullptr);
     ~XEmbedTrayWidget();
 
     QString itemKeyForConfig() override;
@@ -29,6 +30,7 @@ public:
     static QString getWindowProperty(quint32 winId, QString propName);
     static QString toXEmbedKey(quint32 winId);
     static uint getWindowPID(quint32 winId);
+    static void syncWindowInfo(const QList<quint32> &winIds);
     static bool isXEmbedKey(const QString &itemKey);
     virtual bool isValid() override {return m_valid;}
 
@@ -41,6 +43,10 @@ private:
     void wrapWindow();
     void sendHoverEvent();
     void refershIconImage();
+    QImage captureWindowImage(xcb_connection_t *c);
+    bool updateClientSize(xcb_connection_t *c);
+    bool attachShm(xcb_connection_t *c, uint32_t size);
+    void releaseShm(xcb_connection_t *c);
 
     static QString getAppNameForWindow(quint32 winId);
 
@@ -69,6 +75,16 @@ private:
     xcb_connection_t *m_xcbCnn;
     Display* m_display;
     InjectMode m_injectMode;
+
+    // 托盘窗口的大小，截图时不再每次获取
+    QSize m_clientSize;
+    // 通过MIT-SHM截图时使用的共享内存
+    uint32_t m_shmSeg;
+    void *m_shmAddr;
+    uint32_t m_shmSize;
+    bool m_shmUnsupported;
+    // 通过Damage事件刷新图标，不需要再依赖定时器
+    bool m_damageWatched;
 };
 
 #endif // XEMBEDTRAYWIDGET_H
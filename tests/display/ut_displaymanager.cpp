@@ -30,6 +30,14 @@ TEST_F(Test_DisplayManager, method_test)
 
     ASSERT_FALSE(DisplayManager::instance()->screen("testname"));
 
+    const ScreenTopologyPtr topology = DisplayManager::instance()->topology();
+    ASSERT_EQ(topology->count(), qApp->screens().count());
+    ASSERT_EQ(DisplayManager::instance()->screenRawWidth(), topology->rawWidth());
+
+    // 布局没有变化时不生成新的快照
+    DisplayManager::instance()->dockInfoChanged();
+    ASSERT_EQ(DisplayManager::instance()->topology(), topology);
+
     ASSERT_EQ(DisplayManager::instance()->primary(), qApp->primaryScreen() ? qApp->primaryScreen()->name() : QString());
 
     // 第一次启动的时候，默认发出一次信号
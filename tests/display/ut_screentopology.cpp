@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <QObject>
+#include <QTest>
+
+#include <gtest/gtest.h>
+
+#include "screentopology.h"
+
+class Test_ScreenTopology : public ::testing::Test
+{
+};
+
+TEST_F(Test_ScreenTopology, single_screen_test)
+{
+    ScreenTopology topology(QVector<QRect>() << QRect(0, 0, 1920, 1080), 0, false, 1);
+
+    ASSERT_EQ(topology.count(), 1);
+    ASSERT_EQ(topology.version(), 1u);
+    ASSERT_EQ(topology.rawWidth(), 1920);
+    ASSERT_EQ(topology.rawHeight(), 1080);
+    ASSERT_EQ(topology.dockableEdges(0), quint8(ScreenTopology::AllEdges));
+    ASSERT_EQ(topology.indexAt(QPoint(100, 100)), 0);
+    ASSERT_EQ(topology.indexAt(QPoint(1920, 100)), -1);
+    ASSERT_FALSE(topology.screenAt(QPoint(100, 100)));
+    ASSERT_FALSE(topology.canDock(1, Bottom));
+}
+
+TEST_F(Test_ScreenTopology, adjacency_test)
+{
+    // 2x2拼接，相邻屏幕的拼接处不能停靠
+    QVector<QRect> rects;
+    rects << QRect(0, 0, 1920, 1080) << QRect(1920, 0, 1920, 1080)
+          << QRect(0, 1080, 1920, 1080) << QRect(1920, 1080, 1920, 1080);
+    ScreenTopology topology(rects, 0, false, 1);
+
+    ASSERT_EQ(topology.rawWidth(), 3840);
+    ASSERT_EQ(topology.rawHeight(), 2160);
+    ASSERT_EQ(topology.dockableEdges(0), quint8(ScreenTopology::TopEdge | ScreenTopology::LeftEdge));
+    ASSERT_EQ(topology.dockableEdges(1), quint8(ScreenTopology::TopEdge | ScreenTopology::RightEdge));
+    ASSERT_EQ(topology.dockableEdges(2), quint8(ScreenTopology::BottomEdge | ScreenTopology::LeftEdge));
+    ASSERT_EQ(topology.dockableEdges(3), quint8(ScreenTopology::BottomEdge | ScreenTopology::RightEdge));
+    ASSERT_EQ(topology.indexAt(QPoint(2000, 1200)), 3);
+}
+
+TEST_F(Test_ScreenTopology, diagonal_test)
+{
+    // 对角排列的屏幕不影响停靠
+    QVector<QRect> rects;
+    rects << QRect(0, 0, 1920, 1080) << QRect(1920, 1080, 1920, 1080);
+    ScreenTopology topology(rects, 0, false, 1);
+
+    ASSERT_EQ(topology.dockableEdges(0), quint8(ScreenTopology::AllEdges));
+    ASSERT_EQ(topology.dockableEdges(1), quint8(ScreenTopology::AllEdges));
+
+    // 部分重叠的上下拼接
+    rects.clear();
+    rects << QRect(0, 0, 1920, 1080) << QRect(960, 1080, 1920, 1080);
+    ScreenTopology shifted(rects, 0, false, 2);
+    ASSERT_FALSE(shifted.canDock(0, Bottom));
+    ASSERT_FALSE(shifted.canDock(1, Top));
+    ASSERT_TRUE(shifted.canDock(0, Right));
+    ASSERT_TRUE(shifted.canDock(1, Left));
+}
+
+TEST_F(Test_ScreenTopology, only_primary_test)
+{
+    QVector<QRect> rects;
+    rects << QRect(0, 0, 1920, 1080) << QRect(1920, 0, 1920, 1080);
+    ScreenTopology topology(rects, 1, true, 1);
+
+    ASSERT_EQ(topology.dockableEdges(0), quint8(0));
+    ASSERT_EQ(topology.dockableEdges(1), quint8(ScreenTopology::AllEdges));
+
+    ScreenTopology same(rects, 1, true, 2);
+    ASSERT_TRUE(topology.sameLayout(same));
+    ASSERT_FALSE(topology.sameLayout(ScreenTopology(rects, 0, true, 3)));
+}
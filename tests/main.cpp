@@ -17,6 +17,8 @@
 int main(int argc, char **argv)
 {
     qputenv("QT_QPA_PLATFORM", "offscreen");
+    // 测试中写入的配置只保存在内存中，不影响本机的配置
+    qputenv("GSETTINGS_BACKEND", "memory");
 
     DockApplication app(argc, argv);
     // 设置应用名为dde-dock，否则dconfig相关的配置就读不到了
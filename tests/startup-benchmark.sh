@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# 比较任务栏冷启动(清空图标缓存)和热启动的第一次绘制耗时
+# 用法: ./startup-benchmark.sh [dde-dock可执行文件路径] [每种情况的次数]
+
+DOCK=${1:-/usr/bin/dde-dock}
+ROUNDS=${2:-3}
+CACHE_FILE=${XDG_CACHE_HOME:-$HOME/.cache}/dde-dock/icon-cache.bin
+LOG_FILE=$(mktemp)
+
+run_dock()
+{
+    killall -q dde-dock
+    sleep 1
+
+    $DOCK > $LOG_FILE 2>&1 &
+    for i in $(seq 1 30); do
+        if grep -q "time to first paint" $LOG_FILE; then
+            break
+        fi
+        sleep 1
+    done
+
+    grep -o "time to first paint.*" $LOG_FILE | head -n 1
+}
+
+echo "cold start:"
+for i in $(seq 1 $ROUNDS); do
+    rm -f $CACHE_FILE
+    run_dock
+done
+
+echo "warm start:"
+for i in $(seq 1 $ROUNDS); do
+    run_dock
+done
+
+rm -f $LOG_FILE
+exit 0
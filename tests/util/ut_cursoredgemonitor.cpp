@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "cursoredgemonitor.h"
+
+#include <QSignalSpy>
+
+#include <gtest/gtest.h>
+
+class Ut_CursorEdgeMonitor : public ::testing::Test
+{
+};
+
+TEST_F(Ut_CursorEdgeMonitor, areaAt_test)
+{
+    const QList<QRect> areas { QRect(0, 1065, 1920, 15), QRect(1920, 1065, 1920, 15) };
+
+    ASSERT_EQ(CursorEdgeMonitor::areaAt(areas, QPoint(100, 1079)), 0);
+    ASSERT_EQ(CursorEdgeMonitor::areaAt(areas, QPoint(2000, 1070)), 1);
+    ASSERT_EQ(CursorEdgeMonitor::areaAt(areas, QPoint(100, 500)), -1);
+    ASSERT_EQ(CursorEdgeMonitor::areaAt(QList<QRect>(), QPoint(100, 1079)), -1);
+}
+
+TEST_F(Ut_CursorEdgeMonitor, transition_test)
+{
+    CursorEdgeMonitor monitor;
+    QSignalSpy wakeSpy(&monitor, &CursorEdgeMonitor::wakeAreaEntered);
+    QSignalSpy leaveSpy(&monitor, &CursorEdgeMonitor::dockAreaLeft);
+
+    monitor.setAreas({ QRect(0, 1065, 1920, 15) }, { QRect(0, 1020, 1920, 60) });
+
+    // 区域变化后的第一次位置只用来初始化状态
+    monitor.updatePosition(QPoint(100, 1070));
+    ASSERT_EQ(wakeSpy.count(), 0);
+
+    monitor.updatePosition(QPoint(100, 500));
+    ASSERT_EQ(wakeSpy.count(), 0);
+    ASSERT_EQ(leaveSpy.count(), 1);
+
+    // 在任务栏区域外移动不再通知
+    monitor.updatePosition(QPoint(200, 500));
+    ASSERT_EQ(leaveSpy.count(), 1);
+
+    monitor.updatePosition(QPoint(100, 1079));
+    ASSERT_EQ(wakeSpy.count(), 1);
+    ASSERT_EQ(wakeSpy.first().at(0).toInt(), 100);
+    ASSERT_EQ(wakeSpy.first().at(1).toInt(), 1079);
+
+    // 在唤醒区域内移动时有频率限制
+    monitor.updatePosition(QPoint(101, 1079));
+    ASSERT_EQ(wakeSpy.count(), 1);
+}
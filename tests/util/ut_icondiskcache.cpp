@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "icondiskcache.h"
+
+#include <QPixmap>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+class Ut_IconDiskCache : public ::testing::Test
+{
+public:
+    virtual void SetUp() override;
+    virtual void TearDown() override;
+
+    IconDiskCache *createCache();
+
+public:
+    QTemporaryDir *m_cacheDir = nullptr;
+    QByteArray m_oldCacheHome;
+    IconDiskCache *m_cache = nullptr;
+};
+
+void Ut_IconDiskCache::SetUp()
+{
+    // 缓存文件写到临时目录，不影响用户目录，每次运行的结果也不受上次运行的影响
+    m_oldCacheHome = qgetenv("XDG_CACHE_HOME");
+    m_cacheDir = new QTemporaryDir;
+    qputenv("XDG_CACHE_HOME", m_cacheDir->path().toLocal8Bit());
+
+    m_cache = createCache();
+}
+
+void Ut_IconDiskCache::TearDown()
+{
+    delete m_cache;
+    m_cache = nullptr;
+
+    delete m_cacheDir;
+    m_cacheDir = nullptr;
+
+    if (m_oldCacheHome.isNull())
+        qunsetenv("XDG_CACHE_HOME");
+    else
+        qputenv("XDG_CACHE_HOME", m_oldCacheHome);
+}
+
+IconDiskCache *Ut_IconDiskCache::createCache()
+{
+    // 没有图标主题时缓存不生效，这里使用固定的主题键值，打开文件时也不会清除这个键值的记录
+    return new IconDiskCache("ut-theme@0");
+}
+
+TEST_F(Ut_IconDiskCache, insert_find_test)
+{
+    ASSERT_TRUE(IconDiskCache::cacheFilePath().startsWith(m_cacheDir->path()));
+
+    QPixmap pix(32, 32);
+    pix.fill(Qt::red);
+
+    QPixmap result;
+    ASSERT_FALSE(m_cache->find("ut-disk-cache-icon", 32, 1.0, result));
+
+    m_cache->insert("ut-disk-cache-icon", 32, 1.0, pix);
+    ASSERT_TRUE(m_cache->find("ut-disk-cache-icon", 32, 1.0, result));
+    ASSERT_EQ(result.size(), QSize(32, 32));
+
+    // 大小或缩放比例不同时不能命中
+    ASSERT_FALSE(m_cache->find("ut-disk-cache-icon", 48, 1.0, result));
+    ASSERT_FALSE(m_cache->find("ut-disk-cache-icon", 32, 2.0, result));
+}
+
+TEST_F(Ut_IconDiskCache, reload_test)
+{
+    QPixmap pix(24, 24);
+    pix.fill(Qt::blue);
+    m_cache->insert("ut-disk-cache-reload", 24, 1.0, pix);
+
+    // 模拟重新启动，从映射的文件中读取
+    delete m_cache;
+    m_cache = createCache();
+    m_cache->closeFile();
+    m_cache->load();
+
+    QPixmap result;
+    ASSERT_TRUE(m_cache->find("ut-disk-cache-reload", 24, 1.0, result));
+    ASSERT_EQ(result.toImage().pixelColor(12, 12), QColor(Qt::blue));
+
+    // 主题变化后旧的缓存不再命中
+    m_cache->m_themeKey = "ut-theme@1";
+    ASSERT_FALSE(m_cache->find("ut-disk-cache-reload", 24, 1.0, result));
+}
+
+TEST_F(Ut_IconDiskCache, rewrite_test)
+{
+    QPixmap pix(24, 24);
+    pix.fill(Qt::green);
+    m_cache->insert("ut-disk-cache-old", 24, 1.0, pix);
+    m_cache->insert("ut-disk-cache-old", 32, 1.0, pix.scaled(32, 32));
+
+    const qint64 oldSize = QFileInfo(IconDiskCache::cacheFilePath()).size();
+
+    // 主题变化后重新生成文件，只保留当前主题的记录
+    m_cache->m_themeKey = "ut-theme@1";
+    m_cache->insert("ut-disk-cache-new", 24, 1.0, pix);
+    m_cache->rewrite(true);
+
+    ASSERT_LT(QFileInfo(IconDiskCache::cacheFilePath()).size(), oldSize);
+    ASSERT_EQ(m_cache->m_index.size(), 1);
+
+    QPixmap result;
+    ASSERT_TRUE(m_cache->find("ut-disk-cache-new", 24, 1.0, result));
+    ASSERT_EQ(result.toImage().pixelColor(12, 12), QColor(Qt::green));
+
+    m_cache->m_themeKey = "ut-theme@0";
+    ASSERT_FALSE(m_cache->find("ut-disk-cache-old", 24, 1.0, result));
+
+    // 重新生成后仍然可以继续写入
+    m_cache->insert("ut-disk-cache-old", 24, 1.0, pix);
+    ASSERT_TRUE(m_cache->find("ut-disk-cache-old", 24, 1.0, result));
+}
+
+TEST_F(Ut_IconDiskCache, find_after_rewrite_test)
+{
+    QPixmap pix(24, 24);
+    pix.fill(Qt::yellow);
+    m_cache->insert("ut-disk-cache-mapped", 24, 1.0, pix);
+    m_cache->flushPending();
+
+    // 重新打开后从映射的文件中读取
+    m_cache->closeFile();
+    m_cache->load();
+
+    QPixmap result;
+    ASSERT_TRUE(m_cache->find("ut-disk-cache-mapped", 24, 1.0, result));
+
+    // 文件重新生成后旧的映射被释放，已经返回的图标仍然可以使用
+    m_cache->rewrite(true);
+    ASSERT_EQ(result.toImage().pixelColor(12, 12), QColor(Qt::yellow));
+}
+
+TEST_F(Ut_IconDiskCache, replaced_file_test)
+{
+    QPixmap pix(24, 24);
+    pix.fill(Qt::blue);
+    m_cache->insert("ut-disk-cache-first", 24, 1.0, pix);
+    m_cache->flushPending();
+
+    // 文件被其他实例替换后，写入前重新打开，记录不会写到已经删除的旧文件中
+    IconDiskCache *other = createCache();
+    other->rewrite(true);
+    delete other;
+    ASSERT_TRUE(m_cache->isFileReplaced());
+
+    m_cache->insert("ut-disk-cache-second", 24, 1.0, pix);
+    m_cache->flushPending();
+    ASSERT_FALSE(m_cache->isFileReplaced());
+
+    delete m_cache;
+    m_cache = createCache();
+    m_cache->closeFile();
+    m_cache->load();
+
+    QPixmap result;
+    ASSERT_TRUE(m_cache->find("ut-disk-cache-first", 24, 1.0, result));
+    ASSERT_TRUE(m_cache->find("ut-disk-cache-second", 24, 1.0, result));
+}
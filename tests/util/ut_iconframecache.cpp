@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "iconframecache.h"
+
+#include <gtest/gtest.h>
+
+class Ut_IconFrameCache : public ::testing::Test
+{
+public:
+    virtual void SetUp() override;
+    virtual void TearDown() override;
+
+    qint64 m_budget;
+};
+
+void Ut_IconFrameCache::SetUp()
+{
+    m_budget = IconFrameCache::budget();
+}
+
+void Ut_IconFrameCache::TearDown()
+{
+    IconFrameCache::setBudget(m_budget);
+}
+
+static QPixmap framePixmap(int size)
+{
+    QPixmap pixmap(size, size);
+    pixmap.fill(Qt::red);
+    return pixmap;
+}
+
+TEST_F(Ut_IconFrameCache, insert_find_test)
+{
+    IconFrameCache cache(2);
+    QPixmap pixmap;
+    ASSERT_FALSE(cache.find("normal", pixmap));
+
+    cache.insert("normal", framePixmap(10));
+    cache.insert("attention", framePixmap(20));
+    ASSERT_TRUE(cache.find("normal", pixmap));
+    ASSERT_EQ(pixmap.size(), QSize(10, 10));
+    ASSERT_EQ(cache.bytes(), 10 * 10 * 4 + 20 * 20 * 4);
+
+    // 超出帧数时淘汰最久未使用的attention
+    cache.insert("overlay", framePixmap(10));
+    ASSERT_EQ(cache.count(), 2);
+    ASSERT_FALSE(cache.find("attention", pixmap));
+    ASSERT_TRUE(cache.find("normal", pixmap));
+
+    // 相同的键值替换原来的帧
+    cache.insert("normal", framePixmap(20));
+    ASSERT_EQ(cache.count(), 2);
+    ASSERT_TRUE(cache.find("normal", pixmap));
+    ASSERT_EQ(pixmap.size(), QSize(20, 20));
+}
+
+TEST_F(Ut_IconFrameCache, budget_test)
+{
+    const qint64 totalBytes = IconFrameCache::totalBytes();
+    {
+        IconFrameCache cache1;
+        IconFrameCache cache2;
+        IconFrameCache::setBudget(totalBytes + 10 * 10 * 4 * 2);
+
+        cache1.insert("normal", framePixmap(10));
+        cache2.insert("normal", framePixmap(10));
+        ASSERT_EQ(IconFrameCache::totalBytes(), totalBytes + 10 * 10 * 4 * 2);
+
+        // 超出全局上限时淘汰所有实例中最久未使用的帧
+        QPixmap pixmap;
+        ASSERT_TRUE(cache1.find("normal", pixmap));
+        cache2.insert("attention", framePixmap(10));
+        ASSERT_TRUE(cache1.find("normal", pixmap));
+        ASSERT_FALSE(cache2.find("normal", pixmap));
+        ASSERT_TRUE(cache2.find("attention", pixmap));
+    }
+
+    ASSERT_EQ(IconFrameCache::totalBytes(), totalBytes);
+}
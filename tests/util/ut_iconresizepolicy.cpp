@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "iconresizepolicy.h"
+
+#include <QObject>
+#include <QApplication>
+#include <QTest>
+
+#include <gtest/gtest.h>
+
+class Ut_IconResizePolicy : public ::testing::Test
+{
+public:
+    virtual void TearDown() override;
+};
+
+void Ut_IconResizePolicy::TearDown()
+{
+    qApp->setProperty("DRAG_STATE", false);
+}
+
+TEST_F(Ut_IconResizePolicy, sizeBucket_test)
+{
+    ASSERT_EQ(IconResizePolicy::sizeBucket(1), 16);
+    ASSERT_EQ(IconResizePolicy::sizeBucket(48), 48);
+    ASSERT_EQ(IconResizePolicy::sizeBucket(49), 64);
+    ASSERT_EQ(IconResizePolicy::sizeBucket(150), 192);
+    ASSERT_EQ(IconResizePolicy::sizeBucket(256), 256);
+    ASSERT_EQ(IconResizePolicy::sizeBucket(257), 320);
+}
+
+TEST_F(Ut_IconResizePolicy, refresh_test)
+{
+    QObject owner;
+    int count = 0;
+    IconResizePolicy policy(&owner, [ &count ] { count++; });
+
+    // 没有拖拽时立即刷新
+    policy.requestRefresh();
+    ASSERT_EQ(count, 1);
+    ASSERT_FALSE(policy.isPending());
+
+    // 拖拽过程中不刷新，拖拽结束且大小稳定后只刷新一次
+    qApp->setProperty("DRAG_STATE", true);
+    policy.requestRefresh();
+    policy.requestRefresh();
+    ASSERT_TRUE(policy.isPending());
+    QTest::qWait(150);
+    ASSERT_EQ(count, 1);
+
+    qApp->setProperty("DRAG_STATE", false);
+    QTest::qWait(150);
+    ASSERT_EQ(count, 2);
+    ASSERT_FALSE(policy.isPending());
+
+    qApp->setProperty("DRAG_STATE", true);
+    policy.requestRefresh();
+    policy.cancel();
+    ASSERT_FALSE(policy.isPending());
+}
@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "iconthemepathindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+class Ut_IconThemePathIndex : public ::testing::Test
+{
+public:
+    virtual void SetUp() override;
+
+    void createIcon(const QString &dir, const QString &name, int size);
+
+    QTemporaryDir m_dir;
+};
+
+void Ut_IconThemePathIndex::SetUp()
+{
+    createIcon("16x16/apps", "ut-tray-icon.png", 16);
+    createIcon("48x48/apps", "ut-tray-icon.png", 48);
+    createIcon("32x32/apps", "ut-tray-icon-active.png", 32);
+    createIcon("32x32/apps", "ut-tray-icon-attention.png", 32);
+
+    QDir(m_dir.path()).mkpath("scalable/apps");
+    QFile svg(m_dir.path() + "/scalable/apps/ut-tray-icon.svg");
+    svg.open(QIODevice::WriteOnly);
+    svg.write("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"16\" height=\"16\"/>");
+    svg.close();
+}
+
+void Ut_IconThemePathIndex::createIcon(const QString &dir, const QString &name, int size)
+{
+    QDir(m_dir.path()).mkpath(dir);
+
+    QImage image(size, size, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+    image.save(m_dir.path() + "/" + dir + "/" + name);
+}
+
+TEST_F(Ut_IconThemePathIndex, lookup_test)
+{
+    IconThemePathIndex *index = IconThemePathIndex::instance();
+    QSignalSpy spy(index, &IconThemePathIndex::indexChanged);
+
+    // 第一次查找时在后台建立索引
+    ASSERT_TRUE(index->lookup(m_dir.path(), "ut-tray-icon", 20).isEmpty());
+    ASSERT_TRUE(spy.wait(3000));
+    ASSERT_TRUE(index->isReady(m_dir.path()));
+
+    // 优先选择不小于需要大小的最小图标
+    ASSERT_TRUE(index->lookup(m_dir.path(), "ut-tray-icon", 20).endsWith("48x48/apps/ut-tray-icon.png"));
+    ASSERT_TRUE(index->lookup(m_dir.path(), "UT-Tray-Icon", 16).endsWith("16x16/apps/ut-tray-icon.png"));
+    // 没有足够大的图标时使用矢量图标
+    ASSERT_TRUE(index->lookup(m_dir.path(), "ut-tray-icon", 64).endsWith("scalable/apps/ut-tray-icon.svg"));
+    // 按前缀匹配
+    ASSERT_TRUE(index->lookup(m_dir.path(), "ut-tray-icon-act", 20).endsWith("32x32/apps/ut-tray-icon-active.png"));
+    // 多个图标匹配同一个前缀时固定选择按名称排序的第一个
+    ASSERT_TRUE(index->lookup(m_dir.path(), "ut-tray-icon-a", 20).endsWith("32x32/apps/ut-tray-icon-active.png"));
+    ASSERT_TRUE(index->lookup(m_dir.path(), "ut-unknown", 20).isEmpty());
+}
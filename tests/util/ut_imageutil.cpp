@@ -21,3 +21,28 @@ TEST_F(Test_ImageUtil, coverage_test)
     ASSERT_EQ(ImageUtil::loadSvg(":/res/dde-calendar.svg", "dde-printer", 100, 1.25).size(), QSize(125, 125));
     ASSERT_EQ(ImageUtil::loadSvg("123", "456", 100, 1.25).size(), QSize(125, 125));
 }
+
+TEST_F(Test_ImageUtil, big_endian_argb32_test)
+{
+    // 使用不是4或8的倍数的像素个数，覆盖批量转换后剩余像素的处理
+    const int width = 7;
+    const int height = 3;
+    QByteArray data;
+    for (int i = 0; i < width * height; ++i) {
+        data.append(char(0xff));
+        data.append(char(i));
+        data.append(char(0x80));
+        data.append(char(0x01));
+    }
+
+    const QImage &image = ImageUtil::fromBigEndianARGB32(reinterpret_cast<const uchar *>(data.constData()), width, height);
+    ASSERT_EQ(image.size(), QSize(width, height));
+    for (int i = 0; i < width * height; ++i)
+        ASSERT_EQ(image.pixel(i % width, i / width), qRgba(i, 0x80, 0x01, 0xff));
+
+    // 原地转换
+    ImageUtil::convertFromBigEndianARGB32(reinterpret_cast<const uchar *>(data.constData()), reinterpret_cast<uchar *>(data.data()), width * height);
+    ASSERT_EQ(*reinterpret_cast<const QRgb *>(data.constData() + 4), qRgba(1, 0x80, 0x01, 0xff));
+
+    ASSERT_TRUE(ImageUtil::fromBigEndianARGB32(nullptr, width, height).isNull());
+}
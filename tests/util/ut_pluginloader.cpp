@@ -35,3 +35,24 @@ TEST_F(Test_PluginLoader, loader_test)
 {
     loader->start();
 }
+
+TEST_F(Test_PluginLoader, elf_test)
+{
+    // 测试程序本身链接了dtkcore，读取到的依赖应该和当前进程加载的一致
+    const QString &appPath = QApplication::applicationFilePath();
+
+    PluginLoader::ElfDynamicInfo info;
+    ASSERT_TRUE(PluginLoader::readElfDynamicInfo(appPath, info));
+    ASSERT_FALSE(info.needed.isEmpty());
+
+    const QString &dtkCore = PluginLoader::libUsedDtkCoreFileName(appPath);
+    ASSERT_FALSE(dtkCore.isEmpty());
+    ASSERT_EQ(dtkCore, loader->dtkCoreFileName());
+
+    // 第二次读取命中缓存
+    ASSERT_EQ(PluginLoader::libUsedDtkCoreFileName(appPath), dtkCore);
+
+    ASSERT_FALSE(PluginLoader::readElfDynamicInfo("/proc/self/maps", info));
+    ASSERT_TRUE(PluginLoader::libUsedDtkCoreFileName("/notexists.so").isEmpty());
+    ASSERT_EQ(PluginLoader::realFileName("/notexists.so"), QString("/notexists.so"));
+}
@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "pluginmanifest.h"
+#include "pluginloader.h"
+
+#include <QApplication>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+class UtPluginInter : public PluginsItemInterface
+{
+public:
+    const QString pluginName() const override { return "ut-plugin"; }
+    const QString pluginDisplayName() const override { return "UT Plugin"; }
+    void init(PluginProxyInterface *proxyInter) override { Q_UNUSED(proxyInter); }
+    QWidget *itemWidget(const QString &itemKey) override { Q_UNUSED(itemKey); return nullptr; }
+    bool pluginIsAllowDisable() override { return true; }
+    PluginType type() override { return Fixed; }
+};
+
+class Ut_PluginManifest : public ::testing::Test
+{
+public:
+    virtual void SetUp() override;
+    virtual void TearDown() override;
+
+    QTemporaryDir m_dir;
+    QString m_pluginFile;
+};
+
+void Ut_PluginManifest::SetUp()
+{
+    // 测试程序本身也是ELF文件，复制到临时目录中作为插件文件
+    m_pluginFile = m_dir.path() + "/libut-plugin.so";
+    QFile::copy(QApplication::applicationFilePath(), m_pluginFile);
+}
+
+void Ut_PluginManifest::TearDown()
+{
+    QFile::remove(PluginManifest::manifestFilePath(m_dir.path()));
+}
+
+TEST_F(Ut_PluginManifest, manifest_test)
+{
+    PluginManifest *manifest = PluginManifest::instance();
+
+    // 不是Qt插件，没有元数据
+    ASSERT_TRUE(manifest->metaData(m_pluginFile).value("MetaData").toObject().isEmpty());
+    ASSERT_EQ(manifest->dtkCore(m_pluginFile), PluginLoader::libUsedDtkCoreFileName(m_pluginFile));
+    ASSERT_TRUE(manifest->pluginName(m_pluginFile).isEmpty());
+
+    UtPluginInter inter;
+    manifest->setPluginInfo(m_pluginFile, &inter);
+    ASSERT_EQ(manifest->pluginName(m_pluginFile), QString("ut-plugin"));
+
+    manifest->save();
+    ASSERT_TRUE(QFile::exists(PluginManifest::manifestFilePath(m_dir.path())));
+
+    // 模拟重新启动，从文件中读取
+    manifest->m_entries.clear();
+    manifest->m_loadedDirs.clear();
+    ASSERT_EQ(manifest->pluginName(m_pluginFile), QString("ut-plugin"));
+    ASSERT_EQ(manifest->pluginDisplayName(m_pluginFile), QString("UT Plugin"));
+    ASSERT_TRUE(manifest->pluginAllowDisable(m_pluginFile));
+    ASSERT_EQ(manifest->pluginType(m_pluginFile), PluginsItemInterface::Fixed);
+
+    // 插件文件变化后缓存失效
+    QFile file(m_pluginFile);
+    ASSERT_TRUE(file.open(QIODevice::Append));
+    file.write("ut");
+    file.close();
+    ASSERT_TRUE(manifest->pluginName(m_pluginFile).isEmpty());
+}
@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "pluginstub.h"
+
+#include <QSignalSpy>
+
+#include <gtest/gtest.h>
+
+class UtPluginProxy : public PluginProxyInterface
+{
+public:
+    void itemAdded(PluginsItemInterface * const, const QString &) override {}
+    void itemUpdate(PluginsItemInterface * const, const QString &) override {}
+    void itemRemoved(PluginsItemInterface * const, const QString &) override {}
+    void requestWindowAutoHide(PluginsItemInterface * const, const QString &, const bool) override {}
+    void requestRefreshWindowVisible(PluginsItemInterface * const, const QString &) override {}
+    void requestSetAppletVisible(PluginsItemInterface * const, const QString &, const bool) override {}
+    void saveValue(PluginsItemInterface * const, const QString &key, const QVariant &value) override { m_values.insert(key, value); }
+    const QVariant getValue(PluginsItemInterface *const, const QString &key, const QVariant &fallback = QVariant()) override { return m_values.value(key, fallback); }
+    void removeValue(PluginsItemInterface *const, const QStringList &) override {}
+
+    QVariantMap m_values;
+};
+
+class Ut_PluginStub : public ::testing::Test
+{
+};
+
+TEST_F(Ut_PluginStub, stub_test)
+{
+    UtPluginProxy proxy;
+    proxy.m_values.insert("enable", false);
+
+    PluginStub stub("/usr/lib/dde-dock/plugins/libut.so", "ut-plugin", "UT Plugin", PluginsItemInterface::Fixed);
+    stub.init(&proxy);
+
+    ASSERT_EQ(stub.pluginName(), QString("ut-plugin"));
+    ASSERT_EQ(stub.pluginDisplayName(), QString("UT Plugin"));
+    ASSERT_EQ(stub.type(), PluginsItemInterface::Fixed);
+    ASSERT_TRUE(stub.pluginIsAllowDisable());
+    ASSERT_TRUE(stub.pluginIsDisable());
+    ASSERT_EQ(stub.itemWidget("ut-plugin"), nullptr);
+
+    QSignalSpy spy(&stub, &PluginStub::activateRequested);
+
+    // 配置没有变化时不需要加载插件
+    stub.pluginSettingsChanged();
+    ASSERT_EQ(spy.count(), 0);
+
+    stub.pluginStateSwitched();
+    ASSERT_EQ(spy.count(), 1);
+    ASSERT_TRUE(spy.takeFirst().at(0).toBool());
+
+    proxy.m_values.insert("enable", true);
+    stub.pluginSettingsChanged();
+    ASSERT_EQ(spy.count(), 1);
+    ASSERT_FALSE(spy.takeFirst().at(0).toBool());
+}
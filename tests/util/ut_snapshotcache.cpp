@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "snapshotcache.h"
+
+#include <gtest/gtest.h>
+
+class Ut_SnapshotCache : public ::testing::Test
+{
+public:
+    virtual void SetUp() override;
+    virtual void TearDown() override;
+
+    qint64 m_maxBytes;
+    qint64 m_maxAge;
+};
+
+void Ut_SnapshotCache::SetUp()
+{
+    SnapshotCache *cache = SnapshotCache::instance();
+    m_maxBytes = cache->m_maxBytes;
+    m_maxAge = cache->m_maxAge;
+
+    // 测试中使用的窗口ID不存在，不创建Damage对象
+    cache->m_damageEventBase = 0;
+}
+
+void Ut_SnapshotCache::TearDown()
+{
+    SnapshotCache *cache = SnapshotCache::instance();
+    for (WId wid : cache->m_entries.keys())
+        cache->remove(wid);
+
+    cache->m_maxBytes = m_maxBytes;
+    cache->m_maxAge = m_maxAge;
+}
+
+TEST_F(Ut_SnapshotCache, insert_find_test)
+{
+    SnapshotCache *cache = SnapshotCache::instance();
+
+    QImage image(100, 60, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+
+    QImage result;
+    QRectF srcRect;
+    ASSERT_FALSE(cache->find(1, QSize(184, 114), result, srcRect));
+
+    cache->insert(1, QSize(184, 114), image, QRectF(0, 0, 100, 60));
+    ASSERT_TRUE(cache->find(1, QSize(184, 114), result, srcRect));
+    ASSERT_EQ(result.size(), image.size());
+    ASSERT_EQ(srcRect, QRectF(0, 0, 100, 60));
+    ASSERT_EQ(cache->bytes(), image.sizeInBytes());
+
+    // 目标大小变化时不能命中
+    ASSERT_FALSE(cache->find(1, QSize(368, 228), result, srcRect));
+
+    cache->remove(1);
+    ASSERT_FALSE(cache->find(1, QSize(184, 114), result, srcRect));
+    ASSERT_EQ(cache->bytes(), 0);
+}
+
+TEST_F(Ut_SnapshotCache, lru_test)
+{
+    SnapshotCache *cache = SnapshotCache::instance();
+
+    QImage image(100, 100, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+    cache->m_maxBytes = image.sizeInBytes() * 2;
+
+    QImage result;
+    QRectF srcRect;
+    cache->insert(1, QSize(100, 100), image, image.rect());
+    cache->insert(2, QSize(100, 100), image, image.rect());
+
+    // 使用1之后，再插入时淘汰2
+    ASSERT_TRUE(cache->find(1, QSize(100, 100), result, srcRect));
+    cache->insert(3, QSize(100, 100), image, image.rect());
+
+    ASSERT_TRUE(cache->find(1, QSize(100, 100), result, srcRect));
+    ASSERT_FALSE(cache->find(2, QSize(100, 100), result, srcRect));
+    ASSERT_TRUE(cache->find(3, QSize(100, 100), result, srcRect));
+    ASSERT_LE(cache->bytes(), cache->m_maxBytes);
+}
+
+TEST_F(Ut_SnapshotCache, max_age_test)
+{
+    SnapshotCache *cache = SnapshotCache::instance();
+
+    QImage image(10, 10, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+
+    QImage result;
+    QRectF srcRect;
+    cache->insert(1, QSize(10, 10), image, image.rect());
+    cache->m_maxAge = -1;
+    ASSERT_FALSE(cache->find(1, QSize(10, 10), result, srcRect));
+    ASSERT_EQ(cache->bytes(), 0);
+}
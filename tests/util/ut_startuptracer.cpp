@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "startuptracer.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+class Ut_StartupTracer : public ::testing::Test
+{
+public:
+    virtual void TearDown() override;
+};
+
+void Ut_StartupTracer::TearDown()
+{
+    StartupTracer::instance()->stop();
+}
+
+TEST_F(Ut_StartupTracer, span_test)
+{
+    StartupTracer *tracer = StartupTracer::instance();
+    tracer->start();
+    ASSERT_TRUE(tracer->isEnabled());
+
+    {
+        TraceSpan span("ut-span", "detail");
+    }
+
+    const QJsonArray &events = QJsonDocument::fromJson(tracer->toJson()).object().value("traceEvents").toArray();
+    ASSERT_EQ(events.size(), 2);
+
+    const QJsonObject &event = events.at(1).toObject();
+    ASSERT_EQ(event.value("name").toString(), QString("ut-span detail"));
+    ASSERT_EQ(event.value("ph").toString(), QString("X"));
+    ASSERT_GE(event.value("dur").toDouble(), 0);
+
+    // 停止后不再记录
+    tracer->stop();
+    {
+        TraceSpan span("ut-span-stopped");
+    }
+    ASSERT_EQ(QJsonDocument::fromJson(tracer->toJson()).object().value("traceEvents").toArray().size(), 2);
+
+    QTemporaryDir dir;
+    const QString &filePath = dir.path() + "/trace.json";
+    ASSERT_TRUE(tracer->dump(filePath));
+    ASSERT_TRUE(QFile::exists(filePath));
+    ASSERT_FALSE(tracer->dump(QString()));
+}
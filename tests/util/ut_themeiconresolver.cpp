@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "themeiconresolver.h"
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+class Ut_ThemeIconResolver : public ::testing::Test
+{
+public:
+    virtual void SetUp() override;
+    virtual void TearDown() override;
+
+    QTemporaryDir m_dir;
+};
+
+void Ut_ThemeIconResolver::SetUp()
+{
+    // 构造一个最小的图标主题: ut-theme/16/apps 和 ut-theme/48/apps
+    QDir(m_dir.path()).mkpath("ut-theme/16/apps");
+    QDir(m_dir.path()).mkpath("ut-theme/48/apps");
+
+    QFile index(m_dir.path() + "/ut-theme/index.theme");
+    index.open(QIODevice::WriteOnly);
+    index.write("[Icon Theme]\n"
+                "Name=ut-theme\n"
+                "Directories=16/apps,48/apps\n"
+                "\n"
+                "[16/apps]\n"
+                "Size=16\n"
+                "Type=Fixed\n"
+                "\n"
+                "[48/apps]\n"
+                "Size=48\n"
+                "Type=Fixed\n");
+    index.close();
+
+    QImage image(16, 16, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+    image.save(m_dir.path() + "/ut-theme/16/apps/ut-app.png");
+    image.scaled(48, 48).save(m_dir.path() + "/ut-theme/48/apps/ut-app.png");
+
+    ThemeIconResolver::instance()->clear();
+    ThemeIconResolver::instance()->m_searchPaths = QStringList() << m_dir.path();
+}
+
+void Ut_ThemeIconResolver::TearDown()
+{
+    ThemeIconResolver::instance()->clear();
+}
+
+TEST_F(Ut_ThemeIconResolver, lookup_test)
+{
+    ThemeIconResolver *resolver = ThemeIconResolver::instance();
+
+    ASSERT_TRUE(resolver->lookup("", 48).isEmpty());
+    ASSERT_TRUE(resolver->lookup("utnotexists", 48, "ut-theme").isEmpty());
+
+    ASSERT_EQ(resolver->lookup("ut-app", 48, "ut-theme"), m_dir.path() + "/ut-theme/48/apps/ut-app.png");
+    ASSERT_EQ(resolver->lookup("ut-app", 16, "ut-theme"), m_dir.path() + "/ut-theme/16/apps/ut-app.png");
+    ASSERT_EQ(resolver->lookup("ut-app", 20, "ut-theme"), m_dir.path() + "/ut-theme/16/apps/ut-app.png");
+
+    // 找不到时去掉最后一个'-'后缀继续查找
+    ASSERT_EQ(resolver->lookup("ut-app-symbolic", 48, "ut-theme"), m_dir.path() + "/ut-theme/48/apps/ut-app.png");
+
+    const QString &filePath = m_dir.path() + "/ut-theme/16/apps/ut-app.png";
+    ASSERT_EQ(resolver->lookup(filePath, 48), filePath);
+}
+
+TEST_F(Ut_ThemeIconResolver, resolve_test)
+{
+    ThemeIconResolver *resolver = ThemeIconResolver::instance();
+    resolver->m_themeName = "ut-theme";
+
+    ASSERT_EQ(resolver->resolve("ut-app", 48).result(), m_dir.path() + "/ut-theme/48/apps/ut-app.png");
+
+    const QImage &image = resolver->resolveImage("ut-app", 32).result();
+    ASSERT_FALSE(image.isNull());
+    ASSERT_EQ(image.size(), QSize(32, 32));
+
+    ASSERT_TRUE(resolver->resolveImage("", 32).result().isNull());
+}
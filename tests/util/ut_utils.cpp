@@ -62,4 +62,26 @@ TEST_F(Ut_Utils, renderSVG_test)
 TEST_F(Ut_Utils, gsettings_test)
 {
     ASSERT_FALSE(Utils::SettingValue("", "").isValid());
+
+    // 不存在的schema只查找一次，之后直接返回默认值
+    ASSERT_EQ(Utils::SettingValue("com.deepin.dde.dock.test", QByteArray(), "test", 10).toInt(), 10);
+    ASSERT_EQ(Utils::SettingValue("com.deepin.dde.dock.test", QByteArray(), "test", 20).toInt(), 20);
+    ASSERT_TRUE(Utils::SettingsRegistry::instance()->m_entries.contains("com.deepin.dde.dock.test@"));
+    ASSERT_FALSE(Utils::SettingSaveValue("com.deepin.dde.dock.test", QByteArray(), "test", 30));
+}
+
+TEST_F(Ut_Utils, gsettings_save_test)
+{
+    const QString schema("com.deepin.dde.dock.distancemultiple");
+    const QByteArray path("/com/deepin/dde/dock/distancemultiple/");
+    if (!QGSettings::isSchemaInstalled(schema.toUtf8()))
+        return;
+
+    // 写入时会同步发出changed信号，不能死锁，写入后读取到的是新的值而不是缓存的旧值
+    ASSERT_TRUE(Utils::SettingSaveValue(schema, path, "distance-multiple", 2.5));
+    ASSERT_DOUBLE_EQ(Utils::SettingValue(schema, path, "distance-multiple", 1.5).toDouble(), 2.5);
+    ASSERT_TRUE(Utils::SettingSaveValue(schema, path, "distance-multiple", 3.0));
+    ASSERT_DOUBLE_EQ(Utils::SettingValue(schema, path, "distance-multiple", 1.5).toDouble(), 3.0);
+
+    ASSERT_FALSE(Utils::SettingSaveValue(schema, path, "not-exist-key", 1));
 }
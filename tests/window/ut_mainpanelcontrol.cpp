@@ -327,3 +327,19 @@ TEST_F(Test_MainPanelControl, addItem)
 
     ASSERT_TRUE(true);
 }
+
+TEST_F(Test_MainPanelControl, resizeDockIcon)
+{
+    MainPanelControl panel;
+    panel.resize(1000, 40);
+
+    // 同一帧内多次请求只计算一次
+    panel.resizeDockIcon();
+    ASSERT_TRUE(panel.m_layoutTimer->isActive());
+    panel.resizeDockIcon();
+    ASSERT_TRUE(panel.m_layoutTimer->isActive());
+
+    QTest::qWait(50);
+    ASSERT_FALSE(panel.m_layoutTimer->isActive());
+    ASSERT_TRUE(panel.updatesEnabled());
+}